@@ -14,10 +14,14 @@
 #include "src/comms.h"
 #include "src/slideshow.h"
 #include "src/si4684.h"
+#include "src/radiotask.h"
+#include "src/muxdb.h"
 #include "src/TPA6130A2.h"
 
 TPA6130A2 Headphones;
 DAB radio;
+Si468xEmulator emulator;
+RadioSnapshot snapshot;
 
 TFT_eSPI tft = TFT_eSPI(240, 320);
 
@@ -30,6 +34,8 @@ bool menu;
 bool menuopen;
 bool resetFontOnNextCall;
 bool seek;
+bool seekwait;
+bool servicesearch;
 bool setupmode;
 bool setvolume;
 bool ShowServiceInformation;
@@ -105,11 +111,15 @@ String PSold;
 String RTold;
 String SIDold;
 String SignalLeveloldString;
+uint16_t announcements;
+uint16_t announcementsActive;  // Last mask posted to the radio task
 uint16_t BitrateOld;
 uint32_t _serviceID;
+uint32_t searchID;
 uint8_t freq = 0;
 uint8_t service = 0;
 unsigned long tottimer;
+unsigned long recoverytime;
 unsigned long rssiTimer;
 unsigned long rtticker;
 unsigned long rttickerhold;
@@ -122,6 +132,7 @@ typedef struct _Memory {
   byte      Channel;
   uint32_t  ServiceID;
   char      Label[17];
+  uint16_t  Announce;
 } DABMemory;
 
 TFT_eSprite FullLineSprite = TFT_eSprite(&tft);
@@ -138,6 +149,8 @@ void DefaultSettings(void);
 void read_encoder(void);
 void read_encoder2(void);
 void DoMemoryPosTune(void);
+void applyAnnouncements(void);
+void setAnnouncements(uint16_t mask);
 void ProcessDAB(void);
 void Seek(bool mode);
 void deepSleep(void);
@@ -152,7 +165,6 @@ void SlideShowButtonPress(void);
 void StandbyButtonPress(void);
 void ButtonPress(void);
 void Button2Press(void);
-void doRecovery(void);
 void doStandby(void);
 void DABSelectService(bool dir);
 bool IsStationEmpty(void);
@@ -170,15 +182,14 @@ void setup(void) {
   gpio_set_drive_capability((gpio_num_t) 22, GPIO_DRIVE_CAP_0);
   setupmode = true;
 
-  // Initialize and format LittleFS (clean slate on every boot)
+  // Initialize LittleFS (clean slate on every boot but for the multiplex database, kept when waking from standby)
   if (!LittleFS.begin(false)) {
     LittleFS.format();
     LittleFS.begin(false);
-  } else {
-    LittleFS.format();
-    LittleFS.end();
-    LittleFS.begin(false);
+  } else if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_EXT0) {
+    muxdbClean();
   }
+  muxdbBegin();
 
   Serial.begin(1000000);
 
@@ -197,6 +208,7 @@ void setup(void) {
   tot = EEPROM.readByte(EE_BYTE_TOT);
   CurrentTheme = EEPROM.readByte(EE_BYTE_THEME);
   radio.BufferSlideShow = EEPROM.readByte(EE_BYTE_BUFFERSLIDESHOW);
+  announcements = EEPROM.readUShort(EE_UINT16_ANNOUNCE);
 
   for (int i = 0; i < EE_PRESETS_CNT; i++) {
     memory[i].Channel = EEPROM.readByte(i + EE_PRESETS_FREQ_START);
@@ -205,6 +217,7 @@ void setup(void) {
       memory[i].Label[y] = EEPROM.readByte((i * 17) + y + EE_PRESETS_NAME_START);
     }
     memory[i].Label[16] = '\0';
+    memory[i].Announce = EEPROM.readUShort((i * 2) + EE_PRESETS_ANNOUNCE_START);
   }
 
   Headphones.Init();
@@ -304,20 +317,22 @@ void setup(void) {
     delay(30);
   }
 
-  if (radio.begin(15)) {
+  if (LittleFS.exists(SI468X_EMU_FILE) && emulator.load(SI468X_EMU_FILE)) radio.setBus(&emulator);  // Develop without a tuner board
+  if (radio.begin(SI4684_SS, SI4684_INTB, esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0)) {
     tftPrint(0, String(radio.getChipID()) + " v" + String(radio.getFirmwareVersion()), 160, 210, TFT_WHITE, TFT_DARKGREY, 16);
   } else {
     tftPrint(0, myLanguage[language][77], 160, 210, TFT_WHITE, TFT_DARKGREY, 16);
     for (;;);
   }
 
-  delay(1500);
+  if (!radio.WarmStart) delay(1500);
 
   if (tunemode == TUNE_MEM && !IsStationEmpty()) {
     DoMemoryPosTune();
   } else {
     if (tunemode == TUNE_MEM) tunemode = TUNE_MAN;
     radio.setFreq(dabfreq);
+    muxdbRestore(dabfreq);
     EEPROM.get(EE_UINT32_SERVICEID, _serviceID);
     for (int i = 0; i < 16; i++) {
       _serviceName[i] = EEPROM.readByte(i + EE_CHAR17_SERVICENAME);
@@ -325,6 +340,9 @@ void setup(void) {
   }
   if (_serviceID != 0 ) trysetservice = true;
 
+  radioStart(dabfreq);
+  applyAnnouncements();
+  radioSnapshot(snapshot);
   BuildDisplay();
   setupmode = false;
   tottimer = millis();
@@ -351,7 +369,7 @@ void loop(void) {
       attachInterrupt(digitalPinToInterrupt(ROTARY_PIN_A), read_encoder, CHANGE);
       attachInterrupt(digitalPinToInterrupt(ROTARY_PIN_B), read_encoder, CHANGE);
     } else if (tuning) {
-      radio.setFreq(dabfreq);
+      radioPost(RADIO_TUNE, dabfreq);
       tuning = false;
       if (tunemode == TUNE_MEM) trysetservice = true;
     }
@@ -379,24 +397,54 @@ void loop(void) {
 }
 
 void ProcessDAB(void) {
-  if (!tuning) {
-    radio.Update();
-    SignalLevel = radio.getRSSI();
-  }
+  // The radio task owns the Si4684, this side only posts commands and reads snapshots
+  RadioMessage event;
+  while (radioEvent(event)) {
+    switch (event.type) {
+      case RADIO_SCAN_PROGRESS:
+        if (seek) {
+          dabfreq = event.value;
+          ShowFreq();
+        }
+        break;
 
-  if (radio.panic()) doRecovery();
+      case RADIO_FOLLOWED:
+        dabfreq = event.value;
+        if (!menu) ShowFreq();
+        break;
 
-  if (trysetservice && radio.signallock) {
-    for (byte x = 0; x < radio.numberofservices; x++) {
-      if (_serviceID == radio.service[x].ServiceID) {
-        radio.setService(x);
-        radio.ServiceStart = true;
+      case RADIO_SCAN_DONE:
+        if (seekwait) dabfreq = event.value & 0xFF;
+        if (seek) {
+          seek = false;
+          ShowFreq();
+        }
+        seekwait = false;
+        break;
+
+      case RADIO_SERVICE_STARTED:
+        servicesearch = false;
         trysetservice = false;
         store = true;
-      }
+        break;
+
+      case RADIO_RECOVERED:
+        trysetservice = true;
+        servicesearch = false;
+        break;
     }
   }
 
+  radioSnapshot(snapshot);
+  if (!tuning) SignalLevel = snapshot.rssi;
+
+  if (trysetservice && (!servicesearch || searchID != _serviceID)) {
+    servicesearch = radioPost(RADIO_FIND_SERVICE, _serviceID);
+    searchID = _serviceID;
+  } else if (!trysetservice && servicesearch) {
+    servicesearch = !radioPost(RADIO_FIND_CANCEL);
+  }
+
   if (!SlideShowView && !menu) {
     if (!ChannelListView) ShowSignalLevel();
     ShowRT();
@@ -438,19 +486,14 @@ void closeVolume(void) {
   }
 }
 
-void doRecovery(void) {
-  radio.begin(15);
-  radio.setFreq(dabfreq);
-  trysetservice = true;
-}
 
 void DABSelectService(bool dir) {
-  if (radio.numberofservices > 0) {
+  if (snapshot.numberofservices > 0) {
     bool hasValidService = false;
-    for (int i = 0; i < radio.numberofservices; i++) {
-      if (radio.service[i].ServiceType == 0x00 ||
-          radio.service[i].ServiceType == 0x04 ||
-          radio.service[i].ServiceType == 0x05) {
+    for (int i = 0; i < snapshot.numberofservices; i++) {
+      if (snapshot.service[i].ServiceType == 0x00 ||
+          snapshot.service[i].ServiceType == 0x04 ||
+          snapshot.service[i].ServiceType == 0x05) {
         hasValidService = true;
         break;
       }
@@ -458,36 +501,31 @@ void DABSelectService(bool dir) {
 
     if (!hasValidService) return;
 
-    if (dir) {
-      radio.ServiceIndex = (radio.ServiceIndex + 1) % radio.numberofservices;
-    } else {
-      radio.ServiceIndex = (radio.ServiceIndex == 0) ? (radio.numberofservices - 1) : (radio.ServiceIndex - 1);
-    }
-
-    while (radio.service[radio.ServiceIndex].ServiceType != 0x00 &&
-           radio.service[radio.ServiceIndex].ServiceType != 0x04 &&
-           radio.service[radio.ServiceIndex].ServiceType != 0x05) {
+    uint8_t index = snapshot.ServiceIndex;
+    do {
       if (dir) {
-        radio.ServiceIndex = (radio.ServiceIndex + 1) % radio.numberofservices;
+        index = (index + 1) % snapshot.numberofservices;
       } else {
-        radio.ServiceIndex = (radio.ServiceIndex == 0) ? (radio.numberofservices - 1) : (radio.ServiceIndex - 1);
+        index = (index == 0) ? (snapshot.numberofservices - 1) : (index - 1);
       }
-    }
+    } while (snapshot.service[index].ServiceType != 0x00 &&
+             snapshot.service[index].ServiceType != 0x04 &&
+             snapshot.service[index].ServiceType != 0x05);
 
-    radio.setService(radio.ServiceIndex);
-    radio.ServiceStart = true;
+    radioPost(RADIO_SERVICE, snapshot.service[index].ServiceID);
+    radioSnapshot(snapshot);
     store = true;
   }
 }
 
 void StoreFrequency(void) {
-  EEPROM.put(EE_UINT32_SERVICEID, radio.service[radio.ServiceIndex].ServiceID);
+  EEPROM.put(EE_UINT32_SERVICEID, snapshot.service[snapshot.ServiceIndex].ServiceID);
   EEPROM.put(EE_BYTE_DABFREQ, dabfreq);
   for (int i = 0; i < 16; i++) {
-    EEPROM.writeByte(i + EE_CHAR17_SERVICENAME, radio.PStext[i]);
+    EEPROM.writeByte(i + EE_CHAR17_SERVICENAME, snapshot.PStext[i]);
   }
   EEPROM.commit();
-  _serviceID = radio.service[radio.ServiceIndex].ServiceID;
+  _serviceID = snapshot.service[snapshot.ServiceIndex].ServiceID;
 }
 
 void ButtonPress(void) {
@@ -503,16 +541,18 @@ void ButtonPress(void) {
       } else {
         memorystore = false;
         EEPROM.writeByte(memorypos + EE_PRESETS_FREQ_START, dabfreq);
-        EEPROM.put((memorypos * 8) + EE_PRESETS_SERVICEID_START, radio.service[radio.ServiceIndex].ServiceID);
+        EEPROM.put((memorypos * 8) + EE_PRESETS_SERVICEID_START, snapshot.service[snapshot.ServiceIndex].ServiceID);
         for (int x = 0; x < 16; x++) {
-          char character = radio.service[radio.ServiceIndex].Label[x];
+          char character = snapshot.service[snapshot.ServiceIndex].Label[x];
           EEPROM.writeByte((memorypos * 17) + x + EE_PRESETS_NAME_START, character);
           memory[memorypos].Label[x] = character;
         }
         EEPROM.writeByte((memorypos * 17) + 16 + EE_PRESETS_NAME_START, '\0');
         memory[memorypos].Label[16] = '\0';
         memory[memorypos].Channel = dabfreq;
-        memory[memorypos].ServiceID = radio.service[radio.ServiceIndex].ServiceID;
+        memory[memorypos].ServiceID = snapshot.service[snapshot.ServiceIndex].ServiceID;
+        EEPROM.writeUShort((memorypos * 2) + EE_PRESETS_ANNOUNCE_START, announcementsActive);
+        memory[memorypos].Announce = announcementsActive;
         EEPROM.commit();
 
         ShowTuneMode();
@@ -566,6 +606,7 @@ void SlideShowButtonPress(void) {
 
 void ModeButtonPress(void) {
   tottimer = millis();
+  if (seekwait) radioPost(RADIO_SCAN_CANCEL);
   seek = false;
   unsigned long counterold = millis();
   unsigned long counter = millis();
@@ -591,6 +632,7 @@ void ModeButtonPress(void) {
     if (counter - counterold <= 1000) {
       tunemode++;
       if (tunemode > 2) tunemode = 0;
+      applyAnnouncements();
       ShowTuneMode();
       ShowMemoryPos();
     } else {
@@ -617,6 +659,8 @@ void StandbyButtonPress(void) {
     memory[memorypos].Label[16] = '\0';
     memory[memorypos].Channel = EE_PRESETS_FREQUENCY;
     memory[memorypos].ServiceID = 0;
+    EEPROM.writeUShort((memorypos * 2) + EE_PRESETS_ANNOUNCE_START, ANNOUNCEMENT_DEFAULT);
+    memory[memorypos].Announce = ANNOUNCEMENT_DEFAULT;
     EEPROM.commit();
     memorystore = false;
     ShowTuneMode();
@@ -655,17 +699,13 @@ void KeyUp(void) {
           if (dabfreq > 37) dabfreq = 0;
           tuning = true;
           TuningTimer = millis();
-          radio.ServiceIndex = 0;
-          radio.ServiceStart = false;
-          radio.clearData();
+          radioPost(RADIO_CLEAR);
           for (byte x = 0; x < 17; x++) _serviceName[x] = '\0';
           ShowFreq();
           break;
 
         case TUNE_AUTO:
-          radio.ServiceIndex = 0;
-          radio.ServiceStart = false;
-          radio.clearData();
+          radioPost(RADIO_CLEAR);
           direction = true;
           seek = true;
           break;
@@ -692,32 +732,17 @@ void KeyUp(void) {
           break;
       }
     } else {
-      byte y = 0;
-      byte y_old = 0;
-      if (radio.ServiceIndex > 8 && radio.ServiceIndex < 17) {
-        y_old = 9;
-      } else if (radio.ServiceIndex > 16 && radio.ServiceIndex < 25) {
-        y_old = 17;
-      } else if (radio.ServiceIndex > 24) {
-        y_old = 25;
-      }
-
-      ShowOneLine(20 * (radio.ServiceIndex - y_old), radio.ServiceIndex, false);
+      byte y_old = ChannelListTop(snapshot.ServiceIndex);
+      ShowOneLine(20 * (snapshot.ServiceIndex - y_old), snapshot.ServiceIndex, false);
 
-      if (radio.numberofservices > 0) DABSelectService(1);
+      if (snapshot.numberofservices > 0) DABSelectService(1);
 
-      if (radio.ServiceIndex > 8 && radio.ServiceIndex < 17) {
-        y = 9;
-      } else if (radio.ServiceIndex > 16 && radio.ServiceIndex < 25) {
-        y = 17;
-      } else if (radio.ServiceIndex > 24) {
-        y = 25;
-      }
+      byte y = ChannelListTop(snapshot.ServiceIndex);
 
       if (y_old != y) {
         BuildChannelList();
       } else {
-        ShowOneLine(20 * (radio.ServiceIndex - y), radio.ServiceIndex, true);
+        ShowOneLine(20 * (snapshot.ServiceIndex - y), snapshot.ServiceIndex, true);
       }
     }
   } else {
@@ -740,17 +765,13 @@ void KeyDown(void) {
           if (dabfreq > 37) dabfreq = 37;
           tuning = true;
           TuningTimer = millis();
-          radio.ServiceIndex = 0;
-          radio.ServiceStart = false;
-          radio.clearData();
+          radioPost(RADIO_CLEAR);
           for (byte x = 0; x < 17; x++) _serviceName[x] = '\0';
           ShowFreq();
           break;
 
         case TUNE_AUTO:
-          radio.ServiceIndex = 0;
-          radio.ServiceStart = false;
-          radio.clearData();
+          radioPost(RADIO_CLEAR);
           direction = false;
           seek = true;
           break;
@@ -777,32 +798,17 @@ void KeyDown(void) {
           break;
       }
     } else {
-      byte y = 0;
-      byte y_old = 0;
-      if (radio.ServiceIndex > 8 && radio.ServiceIndex < 17) {
-        y_old = 9;
-      } else if (radio.ServiceIndex > 16 && radio.ServiceIndex < 25) {
-        y_old = 17;
-      } else if (radio.ServiceIndex > 24) {
-        y_old = 25;
-      }
-
-      ShowOneLine(20 * (radio.ServiceIndex - y_old), radio.ServiceIndex, false);
+      byte y_old = ChannelListTop(snapshot.ServiceIndex);
+      ShowOneLine(20 * (snapshot.ServiceIndex - y_old), snapshot.ServiceIndex, false);
 
-      if (radio.numberofservices > 0) DABSelectService(0);
+      if (snapshot.numberofservices > 0) DABSelectService(0);
 
-      if (radio.ServiceIndex > 8 && radio.ServiceIndex < 17) {
-        y = 9;
-      } else if (radio.ServiceIndex > 16 && radio.ServiceIndex < 25) {
-        y = 17;
-      } else if (radio.ServiceIndex > 24) {
-        y = 25;
-      }
+      byte y = ChannelListTop(snapshot.ServiceIndex);
 
       if (y_old != y) {
         BuildChannelList();
       } else {
-        ShowOneLine(20 * (radio.ServiceIndex - y), radio.ServiceIndex, true);
+        ShowOneLine(20 * (snapshot.ServiceIndex - y), snapshot.ServiceIndex, true);
       }
     }
   } else {
@@ -817,7 +823,7 @@ void KeyUp2(void) {
     if (volume < 62) volume += 2;
     ShowVolume();
   } else {
-    if (radio.numberofservices > 0) DABSelectService(1);
+    if (snapshot.numberofservices > 0) DABSelectService(1);
     TuningTimer = millis();
   }
   rotary2 = 0;
@@ -832,7 +838,7 @@ void KeyDown2(void) {
     if (volume > 0) volume -= 2;
     ShowVolume();
   } else {
-    if (radio.numberofservices > 0) DABSelectService(0);
+    if (snapshot.numberofservices > 0) DABSelectService(0);
     TuningTimer = millis();
   }
 }
@@ -849,10 +855,29 @@ void DoMemoryPosTune(void) {
     }
 
     ShowFreq();
-    radio.ServiceStart = false;
+    radioPost(RADIO_CLEAR);
     TuningTimer = millis();
     tuning = true;
   }
+  applyAnnouncements();
+}
+
+// A preset carries its own announcement mask, everything else uses the global one
+void applyAnnouncements(void) {
+  announcementsActive = (tunemode == TUNE_MEM && !IsStationEmpty()) ? memory[memorypos].Announce : announcements;
+  radioPost(RADIO_ANNOUNCE, announcementsActive);
+}
+
+void setAnnouncements(uint16_t mask) {
+  if (tunemode == TUNE_MEM && !IsStationEmpty()) {
+    memory[memorypos].Announce = mask;
+    EEPROM.writeUShort((memorypos * 2) + EE_PRESETS_ANNOUNCE_START, mask);
+  } else {
+    announcements = mask;
+    EEPROM.writeUShort(EE_UINT16_ANNOUNCE, mask);
+  }
+  EEPROM.commit();
+  applyAnnouncements();
 }
 
 bool IsStationEmpty(void) {
@@ -870,26 +895,17 @@ void doStandby(void) {
 
   tft.writecommand(0x10);
   Headphones.Shutdown();
+  radioLock();
+  radio.standby();
   esp_sleep_enable_ext0_wakeup(GPIO_NUM_34, LOW);
   esp_deep_sleep_start();
 }
 
 void Seek(bool mode) {
-  if (mode) {
-    dabfreq++;
-    if (dabfreq > 37) dabfreq = 0;
-  } else {
-    dabfreq--;
-    if (dabfreq > 37) dabfreq = 37;
-  }
-  radio.setFreq(dabfreq);
-  radio.ServiceIndex = 0;
-  radio.ServiceStart = false;
-  ShowFreq();
-  radio.Update();
-  if (radio.signallock) {
-    seek = false;
-  }
+  if (seekwait) return;  // The radio task is still scanning, it reports every channel it passes
+
+  radioPost(RADIO_CLEAR);
+  seekwait = radioPost(RADIO_SEEK, dabfreq | (mode ? 0 : 0x100));
 }
 
 void read_encoder(void) {
@@ -944,6 +960,7 @@ void DefaultSettings(void) {
   EEPROM.writeByte(EE_BYTE_THEME, 0);
   EEPROM.put(EE_UINT32_SERVICEID, (uint32_t)0);
   EEPROM.writeByte(EE_BYTE_DABFREQ, 0);
+  EEPROM.writeUShort(EE_UINT16_ANNOUNCE, ANNOUNCEMENT_DEFAULT);
   for (int y = 0; y < 17; y++) {
     EEPROM.writeByte(EE_CHAR17_SERVICENAME + y, '\0');
   }
@@ -954,6 +971,7 @@ void DefaultSettings(void) {
     for (int y = 0; y < 17; y++) {
       EEPROM.writeByte((i * 17) + y + EE_PRESETS_NAME_START, '\0');
     }
+    EEPROM.writeUShort((i * 2) + EE_PRESETS_ANNOUNCE_START, ANNOUNCEMENT_DEFAULT);
   }
   EEPROM.commit();
 }
@@ -1024,6 +1042,8 @@ void tftPrint(int8_t offset, const String & text, int16_t x, int16_t y, int colo
 
 void deepSleep(void) {
   StoreFrequency();
+  radioLock();
+  radio.standby();
   esp_sleep_enable_ext0_wakeup(GPIO_NUM_34, LOW);
   esp_deep_sleep_start();
 }
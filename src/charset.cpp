@@ -0,0 +1,181 @@
+#include "charset.h"
+#include <string.h>
+
+// EBU Latin to Unicode, ETSI TS 101 756 figure C.1. 0 drops the byte, the line break and end of headline codes become a space
+static constexpr uint16_t EBULatin[256] = {
+  0x0000, 0x0118, 0x012E, 0x0172, 0x0102, 0x0116, 0x010E, 0x0218,  // 0x00 - Ę Į Ų Ă Ė Ď Ș
+  0x021A, 0x010A, 0x0020, 0x0020, 0x0120, 0x0139, 0x017B, 0x0143,  // 0x08 Ț Ċ sp sp Ġ Ĺ Ż Ń
+  0x0105, 0x0119, 0x012F, 0x0173, 0x0103, 0x0117, 0x010F, 0x0219,  // 0x10 ą ę į ų ă ė ď ș
+  0x021B, 0x010B, 0x0147, 0x011A, 0x0121, 0x013A, 0x017C, 0x0000,  // 0x18 ț ċ Ň Ě ġ ĺ ż -
+  0x0020, 0x0021, 0x0022, 0x0023, 0x0142, 0x0025, 0x0026, 0x0027,  // 0x20 sp ! " # ł % & '
+  0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,  // 0x28 ( ) * + , - . /
+  0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037,  // 0x30 0 1 2 3 4 5 6 7
+  0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,  // 0x38 8 9 : ; < = > ?
+  0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047,  // 0x40 @ A B C D E F G
+  0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,  // 0x48 H I J K L M N O
+  0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057,  // 0x50 P Q R S T U V W
+  0x0058, 0x0059, 0x005A, 0x005B, 0x016E, 0x005D, 0x0141, 0x005F,  // 0x58 X Y Z [ Ů ] Ł _
+  0x0104, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067,  // 0x60 Ą a b c d e f g
+  0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,  // 0x68 h i j k l m n o
+  0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077,  // 0x70 p q r s t u v w
+  0x0078, 0x0079, 0x007A, 0x00AB, 0x016F, 0x00BB, 0x013D, 0x0126,  // 0x78 x y z « ů » Ľ Ħ
+  0x00E1, 0x00E0, 0x00E9, 0x00E8, 0x00ED, 0x00EC, 0x00F3, 0x00F2,  // 0x80 á à é è í ì ó ò
+  0x00FA, 0x00F9, 0x00D1, 0x00C7, 0x015E, 0x00DF, 0x00A1, 0x0178,  // 0x88 ú ù Ñ Ç Ş ß ¡ Ÿ
+  0x00E2, 0x00E4, 0x00EA, 0x00EB, 0x00EE, 0x00EF, 0x00F4, 0x00F6,  // 0x90 â ä ê ë î ï ô ö
+  0x00FB, 0x00FC, 0x00F1, 0x00E7, 0x015F, 0x011F, 0x0131, 0x00FF,  // 0x98 û ü ñ ç ş ğ ı ÿ
+  0x0136, 0x0145, 0x00A9, 0x0122, 0x011E, 0x011B, 0x0148, 0x0151,  // 0xA0 Ķ Ņ © Ģ Ğ ě ň ő
+  0x0150, 0x20AC, 0x00A3, 0x0024, 0x0100, 0x0112, 0x012A, 0x016A,  // 0xA8 Ő € £ $ Ā Ē Ī Ū
+  0x0137, 0x0146, 0x013B, 0x0123, 0x013C, 0x0130, 0x0144, 0x0171,  // 0xB0 ķ ņ Ļ ģ ļ İ ń ű
+  0x0170, 0x00BF, 0x013E, 0x00B0, 0x0101, 0x0113, 0x012B, 0x016B,  // 0xB8 Ű ¿ ľ ° ā ē ī ū
+  0x00C1, 0x00C0, 0x00C9, 0x00C8, 0x00CD, 0x00CC, 0x00D3, 0x00D2,  // 0xC0 Á À É È Í Ì Ó Ò
+  0x00DA, 0x00D9, 0x0158, 0x010C, 0x0160, 0x017D, 0x00D0, 0x013F,  // 0xC8 Ú Ù Ř Č Š Ž Ð Ŀ
+  0x00C2, 0x00C4, 0x00CA, 0x00CB, 0x00CE, 0x00CF, 0x00D4, 0x00D6,  // 0xD0 Â Ä Ê Ë Î Ï Ô Ö
+  0x00DB, 0x00DC, 0x0159, 0x010D, 0x0161, 0x017E, 0x0111, 0x0140,  // 0xD8 Û Ü ř č š ž đ ŀ
+  0x00C3, 0x00C5, 0x00C6, 0x0152, 0x0177, 0x00DD, 0x00D5, 0x00D8,  // 0xE0 Ã Å Æ Œ ŷ Ý Õ Ø
+  0x00DE, 0x014A, 0x0154, 0x0106, 0x015A, 0x0179, 0x0164, 0x00F0,  // 0xE8 Þ Ŋ Ŕ Ć Ś Ź Ť ð
+  0x00E3, 0x00E5, 0x00E6, 0x0153, 0x0175, 0x00FD, 0x00F5, 0x00F8,  // 0xF0 ã å æ œ ŵ ý õ ø
+  0x00FE, 0x014B, 0x0155, 0x0107, 0x015B, 0x017A, 0x0165, 0x0127,  // 0xF8 þ ŋ ŕ ć ś ź ť ħ
+};
+
+// Every printable code maps to exactly one character, so the table can be checked for gaps at compile time
+static constexpr uint16_t EBULatinDropped(uint16_t index = 0) {
+  return index == 256 ? 0 : (EBULatin[index] == 0 ? 1 : 0) + EBULatinDropped(index + 1);
+}
+static_assert(EBULatinDropped() == 2, "EBU Latin table only drops 0x00 and the word break 0x1F");
+
+static bool charsetIsUTF8(const uint8_t* input, size_t length);
+static uint8_t charsetSequence(const uint8_t* input, size_t length);
+static uint8_t charsetPut(uint16_t code, char* output, size_t position, size_t size);
+
+// Raw bytes of a label up to its terminator, UCS-2 ends on a zero 16 bit unit instead of a zero byte
+size_t charsetLength(const char* input, uint8_t charset, size_t size) {
+  if (!input) return 0;
+  size_t length = 0;
+  if (charset == CHARSET_UCS2) {
+    while (length + 1 < size && (input[length] != 0 || input[length + 1] != 0)) length += 2;
+  } else {
+    while (length < size && input[length] != 0) length++;
+  }
+  return length;
+}
+
+// Straight into the caller's buffer as UTF-8, never splits a character, returns the bytes written
+size_t charsetConvert(const char* input, size_t length, uint8_t charset, char* output, size_t size) {
+  if (!output || size == 0) return 0;
+  const uint8_t* raw = (const uint8_t*)input;
+  size_t position = 0;
+
+  // Broadcasters that send UTF-8 but signal EBU Latin are common enough to check for
+  if (charset == CHARSET_EBU_LATIN && charsetIsUTF8(raw, length)) charset = CHARSET_UTF8;
+
+  switch (charset) {
+    case CHARSET_EBU_LATIN:
+    case CHARSET_LATIN1:
+      for (size_t i = 0; i < length; i++) {
+        uint16_t code = (charset == CHARSET_LATIN1) ? (raw[i] < 0x20 ? 0 : raw[i]) : EBULatin[raw[i]];
+        if (code == 0) continue;
+        uint8_t written = charsetPut(code, output, position, size);
+        if (written == 0) break;
+        position += written;
+      }
+      break;
+
+    case CHARSET_UCS2:
+      for (size_t i = 0; i + 1 < length; i += 2) {
+        uint16_t code = (raw[i] << 8) | raw[i + 1];
+        if (code < 0x20) continue;
+        if (code >= 0xD800 && code <= 0xDFFF) code = '?';  // UCS-2 has no surrogates
+        uint8_t written = charsetPut(code, output, position, size);
+        if (written == 0) break;
+        position += written;
+      }
+      break;
+
+    case CHARSET_UTF8:
+      for (size_t i = 0; i < length;) {
+        uint8_t sequence = charsetSequence(&raw[i], length - i);
+        if (sequence == 0) {
+          if (raw[i] >= 0x20 || raw[i] == 0x0A) {
+            if (position + 1 >= size) break;
+            output[position++] = (raw[i] >= 0x80) ? '?' : (raw[i] == 0x0A ? ' ' : raw[i]);
+          }
+          i++;
+          continue;
+        }
+        if (position + sequence >= size) break;
+        memcpy(&output[position], &raw[i], sequence);
+        position += sequence;
+        i += sequence;
+      }
+      break;
+
+    default:
+      position = (length < size - 1) ? length : size - 1;
+      memcpy(output, raw, position);
+      break;
+  }
+
+  output[position] = '\0';
+  return position;
+}
+
+static bool charsetIsUTF8(const uint8_t* input, size_t length) {
+  bool multibyte = false;
+  for (size_t i = 0; i < length;) {
+    if (input[i] < 0x80) {
+      i++;
+      continue;
+    }
+    uint8_t sequence = charsetSequence(&input[i], length - i);
+    if (sequence == 0) return false;
+    multibyte = true;
+    i += sequence;
+  }
+  return multibyte;
+}
+
+// Length of the well formed multibyte UTF-8 sequence at input, 0 for ASCII, stray or overlong bytes
+static uint8_t charsetSequence(const uint8_t* input, size_t length) {
+  uint8_t lead = input[0];
+  uint8_t sequence;
+  uint32_t code;
+  if ((lead & 0xE0) == 0xC0) {
+    sequence = 2;
+    code = lead & 0x1F;
+  } else if ((lead & 0xF0) == 0xE0) {
+    sequence = 3;
+    code = lead & 0x0F;
+  } else if ((lead & 0xF8) == 0xF0) {
+    sequence = 4;
+    code = lead & 0x07;
+  } else {
+    return 0;
+  }
+  if (sequence > length) return 0;
+
+  for (uint8_t i = 1; i < sequence; i++) {
+    if ((input[i] & 0xC0) != 0x80) return 0;
+    code = (code << 6) | (input[i] & 0x3F);
+  }
+
+  static const uint32_t minimum[5] = {0, 0, 0x80, 0x800, 0x10000};
+  if (code < minimum[sequence] || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) return 0;
+  return sequence;
+}
+
+static uint8_t charsetPut(uint16_t code, char* output, size_t position, size_t size) {
+  uint8_t sequence = (code < 0x80) ? 1 : (code < 0x800) ? 2 : 3;
+  if (position + sequence >= size) return 0;
+
+  if (sequence == 1) {
+    output[position] = code;
+  } else if (sequence == 2) {
+    output[position] = 0xC0 | (code >> 6);
+    output[position + 1] = 0x80 | (code & 0x3F);
+  } else {
+    output[position] = 0xE0 | (code >> 12);
+    output[position + 1] = 0x80 | ((code >> 6) & 0x3F);
+    output[position + 2] = 0x80 | (code & 0x3F);
+  }
+  return sequence;
+}
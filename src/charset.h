@@ -0,0 +1,16 @@
+#ifndef charset_h
+#define charset_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Label character sets, ETSI TS 101 756 table 19
+#define CHARSET_EBU_LATIN   0
+#define CHARSET_LATIN1      4     // ISO/IEC 8859-1
+#define CHARSET_UCS2        6     // ISO/IEC 10646, big endian 16 bit units
+#define CHARSET_UTF8        15
+
+size_t charsetLength(const char* input, uint8_t charset, size_t size);
+size_t charsetConvert(const char* input, size_t length, uint8_t charset, char* output, size_t size);
+
+#endif
@@ -4,14 +4,58 @@ unsigned long signalMillis;
 unsigned int interval = 100;
 byte ServiceIndexOld;
 byte dabfreqOld;
-String ServiceListOld;
-String ServiceInfoOld;
-String ServiceDataOld;
+uint32_t ServiceListHash;       // Of the last $L sent, 0 to send the next one whatever it holds
+char ServiceInfoOld[SERVICE_INFO_MAX];
+char ServiceDataOld[TEXT_TEXT_SIZE];
+uint16_t DLPlusGenerationOld;
 bool connectedSerial;
 
+typedef struct _SlideTransfer {
+  bool          active;
+  uint16_t      id;
+  uint8_t       type;
+  bool          live;         // Served from slideshow.img rather than the per-service cache
+  fs::File      file;         // Open for the whole transfer, closed by doMOTShow() once inactive
+  size_t        size;
+  size_t        sent;
+  size_t        acked;
+  uint8_t       retries;
+  unsigned long ackTimer;
+} SlideTransfer;
+
+typedef struct _ChannelScan {
+  bool          active;
+  bool          finished;     // Set by the radio task after the last line is queued
+  uint8_t       found;        // Ensembles, valid once finished is set
+  uint16_t      dropped;      // Lines the full queue refused, reported with END
+} ChannelScan;
+
+SlideTransfer slide;
+ChannelScan scan;
+SPSCQueue<String, SCAN_LINE_QUEUE> scanLines;
+TelemetrySample telemetry[TELEMETRY_BATCH_MAX];  // The next frame, filled from the radio task's ring
+uint8_t telemetryCount;
+uint8_t telemetryBatch = 16;
+uint16_t telemetryDropped;
+uint16_t telemetryPeriod;
+uint8_t slideWindow = SLIDE_WINDOW_DEFAULT;
+
+uint32_t statsLinesIn;
+uint32_t statsLinesOut;
+uint32_t statsBytesIn;
+uint32_t statsBytesOut;
+unsigned long statsMillis;
+
+uint8_t ficTypeMask;           // Copies of what RADIO_FIC and RADIO_FIC_EXT were last posted with
+uint32_t ficExtMask = 0xFFFFFFFF;
+fs::File traceFile;
+bool traceDump;                // Set by TRACE=0, the recording goes out a chunk per loop once it is closed
+
 void Communication(void) {
   if (Serial.available() > 0) {
     String input = Serial.readStringUntil('\n');
+    statsLinesIn++;
+    statsBytesIn += input.length() + 1;
     unsigned int equalsIndex = input.indexOf('=');
 
     if (equalsIndex == -1) {
@@ -46,6 +90,19 @@ void Communication(void) {
               } else {
                 DataPrint("#1\n");
               }
+            } else if (command.equals("EPG")) {
+              // EPG=<SId in hex>, 0 for the running service
+              uint32_t sid = strtoul(value.c_str(), nullptr, 16);
+              if (sid == 0 && snapshot.ServiceStart) sid = snapshot.service[snapshot.ServiceIndex].ServiceID;
+              EPGProgramme current;
+              EPGProgramme next;
+              if (sid != 0 && epgNowNext(sid, now(), current, next)) {
+                if (current.Start != 0) DataPrint("*EPGNOW=" + String(sid, HEX) + "," + String(current.Start) + "," + String(current.Duration) + "," + String(current.Name) + "\n");
+                if (next.Start != 0) DataPrint("*EPGNEXT=" + String(sid, HEX) + "," + String(next.Start) + "," + String(next.Duration) + "," + String(next.Name) + "\n");
+                DataPrint("#0\n");
+              } else {
+                DataPrint("#1\n");
+              }
             }
             break;
 
@@ -62,12 +119,11 @@ void Communication(void) {
             case 'T':
               if (command.equals("TUNE")) {
                 if (intValue < sizeof(DABfrequencyTable_DAB) / sizeof(DABfrequencyTable_DAB[0])) {
-                  radio.ServiceStart = false;
-                  radio.ServiceIndex = 0;
-                  radio.clearData();
+                  scan.active = false;
+                  radioPost(RADIO_CLEAR);
                   for (byte x = 0; x < 17; x++) _serviceName[x] = '\0';
                   dabfreq = intValue;
-                  radio.setFreq(dabfreq);
+                  radioPost(RADIO_TUNE, dabfreq);
                   if (SlideShowView || ChannelListView || ShowServiceInformation || menu) {
                     SlideShowView = false;
                     ChannelListView = false;
@@ -82,20 +138,126 @@ void Communication(void) {
                 } else {
                   DataPrint("#1\n");
                 }
+              } else if (command.equals("TELEMETRY")) {
+                int commaIndex = value.indexOf(',');
+                unsigned int batch = (commaIndex != -1 ? value.substring(commaIndex + 1).toInt() : telemetryBatch);
+                if (intValue <= 1000 && batch > 0 && batch <= TELEMETRY_BATCH_MAX && radioPost(RADIO_TELEMETRY, intValue)) {
+                  TelemetrySample sample;
+                  while (radioTelemetry(sample));  // Leftovers at the old period
+                  radioTelemetryDropped();
+                  telemetryPeriod = intValue;
+                  telemetryBatch = batch;
+                  telemetryCount = 0;
+                  telemetryDropped = 0;
+                  DataPrint("*TELEMETRY=" + String(telemetryPeriod) + "," + String(telemetryBatch) + "\n#0\n");
+                } else {
+                  DataPrint("#1\n");
+                }
+              } else if (command.equals("TRACE")) {
+                if (intValue == 1 && !snapshot.Tracing && !traceDump && radioPost(RADIO_TRACE, 1)) {
+                  DataPrint("#0\n");
+                } else if (intValue == 0 && snapshot.Tracing && !traceDump && radioPost(RADIO_TRACE, 0)) {
+                  traceDump = true;
+                  DataPrint("#0\n");
+                } else {
+                  DataPrint("#1\n");
+                }
               }
               break;
             case 'S':
               if (command.equals("SERVICE")) {
-                if (intValue < radio.numberofservices) {
-                  radio.ServiceIndex = intValue;
-                  radio.setService(radio.ServiceIndex);
-                  radio.ServiceStart = true;
+                if (intValue < snapshot.numberofservices) {
+                  radioPost(RADIO_SERVICE, snapshot.service[intValue].ServiceID);
+                  radioSnapshot(snapshot);
                   store = true;
-                  DataPrint("#0\n*SERVICE=" + String(radio.ServiceIndex) + "\n");
+                  DataPrint("#0\n*SERVICE=" + String(intValue) + "\n");
                   DataPrint("$M=SLIDESHOW=0\n");
                 } else {
                   DataPrint("#1\n");
                 }
+              } else if (command.equals("SCAN")) {
+                if (intValue == 1 && !scan.active) {
+                  String line;
+                  while (scanLines.pop(line));  // Leftovers of a scan a TUNE cut short
+                  scan.finished = false;
+                  scan.dropped = 0;
+                  scan.active = true;
+                  radioPost(RADIO_CLEAR);
+                  radioSweep(doScanReport);
+                  trysetservice = false;
+                  slide.active = false;
+                  DataPrint("#0\n");
+                } else if (intValue == 0 && scan.active) {
+                  radioPost(RADIO_SCAN_CANCEL);
+                  DataPrint("#0\n");
+                } else {
+                  DataPrint("#1\n");
+                }
+              } else if (command.equals("STATS")) {
+                if (intValue == 0) {
+                  doResetStats();
+                  DataPrint("#0\n");
+                } else if (intValue == 1) {
+                  DataPrint("*STATS=TIME=" + String(millis() - statsMillis) + ",RX=" + String(statsLinesIn) + "," + String(statsBytesIn) + ",TX=" + String(statsLinesOut) + "," + String(statsBytesOut) + ",BOOT=" + String(radio.BootTime) + "," + String(radio.LoadTime) + ",RECOVERY=" + String(recoverytime) + ",PROPSKIP=" + String(radio.getRedundantWrites()) + ",LISTSKIP=" + String(radio.ServiceListSkips) + ",FOLLOW=" + String(FollowSwitches) + "," + String(FollowTime) + ",LABELS=" + String(radio.LabelConversions) + ",ANN=" + String(radio.Announcements) + "," + String(radio.AnnouncementLatency) + ",SDATA=" + String(radio.ServiceDataOverflows) + "," + String(radio.ServiceDataDropped) + "," + String(radio.ServiceDataDeferred) + "\n");
+                } else {
+                  DataPrint("#1\n");
+                }
+              }
+              break;
+            case 'F':
+              if (command.equals("FIC")) {
+                int commaIndex = value.indexOf(',');
+                uint8_t typeMask = strtoul(value.c_str(), nullptr, 16);
+                uint32_t extMask = (commaIndex != -1 ? strtoul(value.substring(commaIndex + 1).c_str(), nullptr, 16) : 0xFFFFFFFF);
+                if (radioPost(RADIO_FIC_EXT, extMask) && radioPost(RADIO_FIC, typeMask)) {
+                  ficTypeMask = typeMask;
+                  ficExtMask = extMask;
+                  DataPrint("*FIC=" + String(ficTypeMask, HEX) + "," + String(ficExtMask, HEX) + "\n#0\n");
+                } else {
+                  DataPrint("#1\n");
+                }
+              } else if (command.equals("FOLLOW")) {
+                if (intValue == 0 || intValue == 1) {
+                  radioPost(RADIO_FOLLOW, intValue);
+                  DataPrint("#0\n");
+                } else {
+                  DataPrint("#1\n");
+                }
+              }
+              break;
+            case 'P':
+              if (command.equals("PING")) {
+                // Echo the host token straight away so the host can time the round trip under load
+                DataPrint("*PING=" + value + "," + String(millis()) + "\n");
+              }
+              break;
+            case 'A':
+              if (command.equals("ACK")) {
+                uint16_t id = strtoul(value.c_str(), nullptr, 16);
+                int commaIndex = value.indexOf(',');
+                if (commaIndex != -1) doSlideAck(id, value.substring(commaIndex + 1).toInt());
+              } else if (command.equals("ANNOUNCE")) {
+                uint16_t mask = strtoul(value.c_str(), nullptr, 16);
+                setAnnouncements(mask);
+                DataPrint("*ANNOUNCE=" + String(mask, HEX) + "\n#0\n");
+              }
+              break;
+            case 'G':
+              if (command.equals("GETSLIDE")) {
+                uint16_t id = strtoul(value.c_str(), nullptr, 16);
+                int commaIndex = value.indexOf(',');
+                size_t offset = (commaIndex != -1 ? value.substring(commaIndex + 1).toInt() : 0);
+                if (doStartSlide(id, offset)) DataPrint("#0\n"); else DataPrint("#1\n");
+              }
+              break;
+            case 'W':
+              if (command.equals("WINDOW")) {
+                if (intValue > 0 && intValue <= SLIDE_WINDOW_MAX) {
+                  slideWindow = intValue;
+                  DataPrint("*WINDOW=" + String(slideWindow) + "\n#0\n");
+                } else {
+                  DataPrint("#1\n");
+                }
               }
               break;
             default:
@@ -120,96 +282,162 @@ void Communication(void) {
   }
 
   if (connectedSerial) {
-    if (radio.ServiceIndex != ServiceIndexOld) {
-      if (radio.ServiceStart) DataPrint("*SERVICE=" + String(radio.ServiceIndex) + "\n");
+    if (snapshot.ServiceIndex != ServiceIndexOld) {
+      if (snapshot.ServiceStart) DataPrint("*SERVICE=" + String(snapshot.ServiceIndex) + "\n");
+      slide.active = false;
       DataPrint("$M=SLIDESHOW=0\n");
-      ServiceIndexOld = radio.ServiceIndex;
+      ServiceIndexOld = snapshot.ServiceIndex;
     }
 
     if (dabfreq != dabfreqOld) {
       DataPrint("*TUNE=" + String(dabfreq) + "\n");
+      slide.active = false;
       DataPrint("$M=SLIDESHOW=0\n");
       dabfreqOld = dabfreq;
     }
 
-    if (ServiceList() != ServiceListOld) {
-      DataPrint(ServiceList());
-      ServiceListOld = ServiceList();
-    }
+    if (scan.active) {
+      doScan();
+    } else {
+      // Only rebuild $L when something it is made of has moved
+      static uint16_t listVersionOld;
+      static uint16_t listComponentsOld;  // Service types arrive one ComponentInfo() at a time after the list
+      static uint8_t listCountOld;
+      static bool listLockOld;
+      static char listLabelOld[17];
+      if (snapshot.ServiceListVersion != listVersionOld || snapshot.ComponentGeneration != listComponentsOld || snapshot.numberofservices != listCountOld || snapshot.signallock != listLockOld || strcmp(snapshot.EnsembleLabel, listLabelOld) != 0 || ServiceListHash == 0) {
+        listVersionOld = snapshot.ServiceListVersion;
+        listComponentsOld = snapshot.ComponentGeneration;
+        listCountOld = snapshot.numberofservices;
+        listLockOld = snapshot.signallock;
+        strcpy(listLabelOld, snapshot.EnsembleLabel);
+
+        // Nothing on the heap here, the loop runs this often enough to fragment it
+        static char list[SERVICE_LIST_MAX];
+        size_t length = ServiceList(list, sizeof(list));
+        uint32_t hash = 2166136261UL;
+        for (size_t i = 0; i < length; i++) hash = (hash ^ (uint8_t)list[i]) * 16777619UL;
+        if (hash == 0) hash = 1;
+        if (hash != ServiceListHash) {
+          DataWrite(list, length);
+          ServiceListHash = hash;
+        }
+      }
 
-    if (ServiceInfo() != ServiceInfoOld) {
-      DataPrint(ServiceInfo());
-      ServiceInfoOld = ServiceInfo();
-    }
+      char info[SERVICE_INFO_MAX];
+      size_t length = ServiceInfo(info, sizeof(info));
+      if (strcmp(info, ServiceInfoOld) != 0) {
+        DataWrite(info, length);
+        memcpy(ServiceInfoOld, info, length + 1);
+      }
 
-    if (String(radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset)) != ServiceDataOld) {
-      DataPrint("$D=RT=" + String(radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset)) + "\n");
-      ServiceDataOld = String(radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset));
+      const char* text = radio.label(snapshot.ServiceData, snapshot.ServiceLabelCharset, sizeof(snapshot.ServiceData));
+      if (strcmp(ServiceDataOld, text) != 0) {
+        DataWrite("$D=RT=", 6);
+        DataWrite(text, strlen(text));
+        DataWrite("\n", 1);
+        snprintf(ServiceDataOld, sizeof(ServiceDataOld), "%s", text);
+      }
+
+      // Now playing fields only go out when the radio task published a change, empty when no longer tagged
+      if (snapshot.DLPlusGeneration != DLPlusGenerationOld) {
+        doDLPlus("ARTIST", DLPLUS_ARTIST);
+        doDLPlus("TITLE", DLPLUS_TITLE);
+        doDLPlus("ALBUM", DLPLUS_ALBUM);
+        doDLPlus("PROGRAMME", DLPLUS_PROGRAMME);
+        DLPlusGenerationOld = snapshot.DLPlusGeneration;
+      }
     }
 
-    if (millis() - signalMillis > interval) {
-      DataPrint("$S=SIGNAL=" + String(SignalLevel / 10) + "." + String(SignalLevel % 10) + ",LOCK=" + String(radio.signallock) + ",CNR=" + String(radio.cnr) + ",FIC=" + String(radio.fic) + "\n");
+    if (telemetryPeriod != 0) {
+      doTelemetry();
+    } else if (millis() - signalMillis > interval) {
+      char line[64];
+      size_t length = snprintf(line, sizeof(line), "$S=SIGNAL=%d.%d,LOCK=%u,CNR=%u,FIC=%u\n", SignalLevel / 10, SignalLevel % 10, snapshot.signallock, snapshot.cnr, snapshot.fic);
+      DataWrite(line, length);
       signalMillis = millis();
     }
 
+    if (ficTypeMask != 0) doFIGStream();
+    if (traceDump) doTraceDump();
     doMOTShow();
   }
 }
 
 static char hashCommand(String command) {
-  if (command.equals("ENABLE")) {
+  if (command.equals("ENABLE") || command.equals("EPG")) {
     return 'E';
-  } else if (command.equals("TUNE")) {
+  } else if (command.equals("TUNE") || command.equals("TELEMETRY") || command.equals("TRACE")) {
     return 'T';
-  } else if (command.equals("SERVICE")) {
+  } else if (command.equals("SERVICE") || command.equals("SCAN") || command.equals("STATS")) {
     return 'S';
+  } else if (command.equals("PING")) {
+    return 'P';
+  } else if (command.equals("FIC") || command.equals("FOLLOW")) {
+    return 'F';
   } else if (command.equals("INTERVAL")) {
     return 'I';
+  } else if (command.equals("ACK") || command.equals("ANNOUNCE")) {
+    return 'A';
+  } else if (command.equals("GETSLIDE")) {
+    return 'G';
+  } else if (command.equals("WINDOW")) {
+    return 'W';
   } else {
     return 0;
   }
 }
 
 static void DataPrint(String data) {
-  Serial.print(data);
+  DataWrite(data.c_str(), data.length());
+}
+
+static void DataWrite(const char* data, size_t length) {
+  statsBytesOut += Serial.write((const uint8_t*)data, length);
+  for (size_t i = 0; i < length; i++) {
+    if (data[i] == '\n') statsLinesOut++;
+  }
 }
 
-static String ServiceList(void) {
-  String ServiceList;
-  ServiceList = "$L=COUNT=" + String(radio.numberofservices) + ",ENSEMBLE=" + String(radio.EID) + "," + String(radio.ASCII(radio.EnsembleLabel, radio.EnsembleLabelCharset)) + ";SERVICES=";
+static void doResetStats(void) {
+  statsLinesIn = 0;
+  statsLinesOut = 0;
+  statsBytesIn = 0;
+  statsBytesOut = 0;
+  statsMillis = millis();
+}
 
-  if (radio.signallock) {
-    for (int x = 0; x < radio.numberofservices; x++) {
-      ServiceList += String(x) + ",";
-      ServiceList += String(radio.service[x].ServiceType);
-      ServiceList += ",";
-      ServiceList += String(radio.ASCII(radio.service[x].Label, radio.ServiceLabelCharset));
+static size_t ServiceList(char* line, size_t size) {
+  size_t pos = snprintf(line, size, "$L=COUNT=%u,ENSEMBLE=%s,%s;SERVICES=", snapshot.numberofservices, snapshot.EID, radio.label(snapshot.EnsembleLabel, snapshot.EnsembleLabelCharset));
 
-      if (x < radio.numberofservices - 1) ServiceList += ";";
+  if (snapshot.signallock) {
+    for (int x = 0; x < snapshot.numberofservices && pos < size; x++) {
+      pos += snprintf(line + pos, size - pos, "%d,%u,%s%s", x, snapshot.service[x].ServiceType, radio.label(snapshot.service[x].Label, snapshot.ServiceLabelCharset), (x < snapshot.numberofservices - 1) ? ";" : "");
     }
-  } else {
-    ServiceList += "0";
+  } else if (pos < size) {
+    pos += snprintf(line + pos, size - pos, "0");
   }
-  ServiceList += "\n";
-  return ServiceList;
+  if (pos > size - 2) pos = size - 2;
+  line[pos++] = '\n';
+  line[pos] = '\0';
+  return pos;
 }
 
-static String ServiceInfo(void) {
-  String ServiceInfo;
-  ServiceInfo = "$I=";
-  ServiceInfo += "ID=" + (radio.ServiceStart ? String(radio.service[radio.ServiceIndex].CompID & 0xFF, DEC) : "0") + ";";
-  ServiceInfo += "SID=" + (radio.ServiceStart ? String(radio.SID) : "0") + ";";
-  ServiceInfo += "PTY=" + (radio.ServiceStart ? String(radio.pty, DEC) : "0") + ";";
-  ServiceInfo += "PROTECTION=" + (radio.ServiceStart ? String(radio.protectionlevel) : "0") + ";";
-  ServiceInfo += "SAMPLERATE=" + (radio.ServiceStart ? String(radio.samplerate) : "0") + ";";
-  ServiceInfo += "BITRATE=" + (radio.ServiceStart ? String(radio.bitrate, DEC) : "0") + ";";
-  ServiceInfo += "AUDIO=" + (radio.ServiceStart ? String(radio.audiomode, DEC) : "0");
-  ServiceInfo += "\n";
-  return ServiceInfo;
+static size_t ServiceInfo(char* line, size_t size) {
+  if (!snapshot.ServiceStart) return snprintf(line, size, "$I=ID=0;SID=0;PTY=0;PROTECTION=0;SAMPLERATE=0;BITRATE=0;AUDIO=0\n");
+  return snprintf(line, size, "$I=ID=%u;SID=%s;PTY=%u;PROTECTION=%u;SAMPLERATE=%u;BITRATE=%u;AUDIO=%u\n",
+                  (unsigned int)(snapshot.service[snapshot.ServiceIndex].CompID & 0xFF), snapshot.SID, snapshot.pty, snapshot.protectionlevel,
+                  snapshot.samplerate, snapshot.bitrate, snapshot.audiomode);
+}
+
+static void doDLPlus(const char* tag, uint8_t field) {
+  char line[TEXT_TEXT_SIZE + 16];
+  size_t length = snprintf(line, sizeof(line), "$D=%s=%s\n", tag, radio.DLPlusText(snapshot.ServiceData, snapshot.DLPlus[field], snapshot.ServiceLabelCharset));
+  DataWrite(line, min(length, sizeof(line) - 1));
 }
 
 static void doEnableConnection(void) {
-  DataPrint("*ENABLE=1," + String(VERSION) + "," + String(radio.getChipID()) + "/" + String(radio.getFirmwareVersion()) + "\n");
+  DataPrint("*ENABLE=1," + String(VERSION) + "," + String(snapshot.Chip) + "\n");
   DataPrint(":MODE=3,3-3\n");
   DataPrint("*INTERVAL=" + String(interval) + "\n");
   DataPrint(":FREQ=" + String(sizeof(DABfrequencyTable_DAB) / sizeof(DABfrequencyTable_DAB[0])) + ",");
@@ -227,88 +455,295 @@ static void doEnableConnection(void) {
   }
   DataPrint("\n");
 
-  if (radio.ServiceStart) DataPrint("*SERVICE=" + String(radio.ServiceIndex) + "\n");
+  if (snapshot.ServiceStart) DataPrint("*SERVICE=" + String(snapshot.ServiceIndex) + "\n");
   DataPrint("*TUNE=" + String(dabfreq) + "\n");
   DataPrint("$M=SLIDESHOW=0\n");
 
-  ServiceListOld = "";
-  ServiceInfoOld = "";
-  ServiceDataOld = "";
+  ServiceListHash = 0;
+  ServiceInfoOld[0] = '\0';
+  ServiceDataOld[0] = '\0';
+  DLPlusGenerationOld = snapshot.DLPlusGeneration - 1;
+  slide.active = false;
+  doResetStats();
   if (radio.SlideShowAvailable) radio.SlideShowUpdate2 = true; else DataPrint("$M=SLIDESHOW=0\n");
 }
 
-static void doMOTShow(void) {
-  if (radio.SlideShowAvailable && radio.SlideShowUpdate2) {
-    DataPrint("$M=SLIDESHOW=");
+static void doScan(void) {
+  // The sweep runs on the radio task, its lines are printed here so they never interleave with other output
+  bool finished = __atomic_load_n(&scan.finished, __ATOMIC_ACQUIRE);
+  String line;
+  while (scanLines.pop(line)) DataPrint(line);
+  if (finished) {
+    // Printed here rather than queued, so a full queue can never swallow it
+    DataPrint("$C=SCAN=END," + String(scan.found) + "," + String(__atomic_load_n(&scan.dropped, __ATOMIC_RELAXED)) + "\n");
+    doScanEnd();
+  }
+}
 
-    fs::File file = LittleFS.open("/slideshow.img", "r");
+static void doScanReport(const ScanResult& result) {
+  // Radio task with the lock held, the tuner is still on result.channel
+  if (result.last) {
+    scan.found = result.found;
+    __atomic_store_n(&scan.finished, true, __ATOMIC_RELEASE);
+    return;
+  }
 
-    if (!file) {
-      DataPrint("3\n");
-      radio.SlideShowUpdate2 = false;
-      return;
+  doScanLine("$C=SCAN=" + String(result.channel) + "," + String(MUXDB_CHANNELS) + "," + String(result.found) + "," + String(result.time) + "," + String(result.result) + "\n");
+
+  if (result.result == SCAN_ENSEMBLE) {
+    String entry = "$C=ENSEMBLE=" + String(result.channel) + "," + String(radio.EID) + "," + radio.ASCII(radio.EnsembleLabel, radio.EnsembleLabelCharset) + ";SERVICES=";
+    for (byte x = 0; x < radio.numberofservices; x++) {
+      entry += String(radio.service[x].ServiceID, HEX) + "," + String(radio.service[x].ServiceType) + "," + radio.ASCII(radio.service[x].Label, radio.ServiceLabelCharset);
+      if (x < radio.numberofservices - 1) entry += ";";
     }
+    doScanLine(entry + "\n");
+  }
+}
 
-    size_t size = file.size();
-    uint8_t* image = (uint8_t*)malloc(size);
+static void doScanLine(const String& line) {
+  if (!scanLines.push(line)) __atomic_add_fetch(&scan.dropped, 1, __ATOMIC_RELAXED);
+}
 
-    if (image == nullptr) {
-      DataPrint("3\n");
-      file.close();
-      radio.SlideShowUpdate2 = false;
+static void doScanEnd(void) {
+  scan.active = false;
+  if (_serviceID != 0) trysetservice = true;
+  ServiceListHash = 0;
+  ServiceInfoOld[0] = '\0';
+}
+
+static void doTraceDump(void) {
+  // One chunk per call, the file stays open until the last one is out
+  if (!traceFile) {
+    if (snapshot.Tracing) return;  // The radio task has not closed the recording yet
+    traceFile = LittleFS.open(SI468X_TRACE_FILE, "r");
+    if (!traceFile) {
+      traceDump = false;
       return;
     }
+    DataPrint("$X=TRACE=" + String(traceFile.size()) + "," + String(snapshot.TraceTruncated ? 1 : 0) + "\n");  // 1 when SI468X_TRACE_MAX cut it short
+  }
 
-    file.read(image, size);
-    file.close();
+  uint8_t raw[SLIDE_CHUNK_SIZE];
+  uint8_t enc[((SLIDE_CHUNK_SIZE + 2) / 3) * 4 + 1];
+  size_t olen;
+  size_t bytesRead = traceFile.read(raw, sizeof(raw));
 
-    size_t buffer_size_needed = (size + 2 - ((size + 2) % 3)) / 3 * 4 + 1;
-    uint8_t *buffer = (uint8_t*)calloc(buffer_size_needed, sizeof(char));
+  if (bytesRead > 0 && mbedtls_base64_encode(enc, sizeof(enc), &olen, raw, bytesRead) == 0) {
+    DataPrint("$X=");
+    DataWrite((const char*)enc, olen);
+    DataPrint("\n");
+  } else {
+    traceFile.close();
+    LittleFS.remove(SI468X_TRACE_FILE);
+    traceDump = false;
+  }
+}
 
-    if (buffer == nullptr) {
-      DataPrint("3\n");
-      free(image);
-      radio.SlideShowUpdate2 = false;
-      return;
-    }
+static void doFIGStream(void) {
+  static char line[FIG_LINE_MAX * 64 + 8];
+  uint8_t fig[32];
+  uint16_t length;
+  size_t pos = 0;
 
-    size_t buff_size = 0;
-    int ret = mbedtls_base64_encode(buffer, buffer_size_needed, &buff_size, image, size);
+  for (uint8_t count = 0; count < FIG_LINE_MAX && (length = radio.getFIG(fig, sizeof(fig))) > 0; count++) {
+    pos += snprintf(line + pos, sizeof(line) - pos, "%s", pos == 0 ? "$F=" : ";");
+    for (uint16_t i = 0; i < length; i++) pos += snprintf(line + pos, sizeof(line) - pos, "%02X", fig[i]);
+  }
 
-    if (ret != 0) {
-      DataPrint("3\n");
-      free(image);
-      free(buffer);
-      radio.SlideShowUpdate2 = false;
-      return;
-    }
+  if (pos > 0) {
+    line[pos++] = '\n';
+    DataWrite(line, pos);
+  }
+}
+
+static void doTelemetry(void) {
+  // The radio task samples the chip, this side only collects a batch and formats it
+  while (telemetryCount < telemetryBatch && radioTelemetry(telemetry[telemetryCount])) telemetryCount++;
+
+  // Hold frames back while the UART is still busy with earlier output, the radio task's ring absorbs the backlog
+  if (telemetryCount >= telemetryBatch && Serial.availableForWrite() >= 64) doTelemetryFrame();
+}
+
+static void doTelemetryFrame(void) {
+  static char frame[TELEMETRY_BATCH_MAX * 24 + 128];
+  int16_t rssiMin = INT16_MAX, rssiMax = INT16_MIN;
+  uint8_t cnrMin = UINT8_MAX, cnrMax = 0, ficMin = UINT8_MAX, ficMax = 0;
+  int32_t rssiSum = 0;
+  uint16_t cnrSum = 0, ficSum = 0;
+
+  for (uint8_t i = 0; i < telemetryBatch; i++) {
+    const TelemetrySample& sample = telemetry[i];
+    if (sample.rssi < rssiMin) rssiMin = sample.rssi;
+    if (sample.rssi > rssiMax) rssiMax = sample.rssi;
+    if (sample.cnr < cnrMin) cnrMin = sample.cnr;
+    if (sample.cnr > cnrMax) cnrMax = sample.cnr;
+    if (sample.fic < ficMin) ficMin = sample.fic;
+    if (sample.fic > ficMax) ficMax = sample.fic;
+    rssiSum += sample.rssi;
+    cnrSum += sample.cnr;
+    ficSum += sample.fic;
+  }
+
+  const TelemetrySample& first = telemetry[0];
+  telemetryDropped += radioTelemetryDropped();
+  size_t length = snprintf(frame, sizeof(frame), "$T=%lu,%u,%u;MIN=%d,%u,%u;MAX=%d,%u,%u;MEAN=%d,%u,%u;S=0,%d,%u,%u",
+                           (unsigned long)first.time, telemetryBatch, telemetryDropped,
+                           rssiMin, cnrMin, ficMin, rssiMax, cnrMax, ficMax,
+                           (int)(rssiSum / telemetryBatch), cnrSum / telemetryBatch, ficSum / telemetryBatch,
+                           first.rssi, first.cnr, first.fic);
+
+  // Following samples are sent as deltas to their predecessor
+  for (uint8_t i = 1; i < telemetryBatch && length < sizeof(frame) - 1; i++) {
+    const TelemetrySample& prev = telemetry[i - 1];
+    const TelemetrySample& sample = telemetry[i];
+    length += snprintf(frame + length, sizeof(frame) - length, ";%lu,%d,%d,%d", (unsigned long)(sample.time - prev.time), sample.rssi - prev.rssi, sample.cnr - prev.cnr, sample.fic - prev.fic);
+  }
+  if (length > sizeof(frame) - 2) length = sizeof(frame) - 2;
+  frame[length++] = '\n';
+
+  DataWrite(frame, length);
+  telemetryCount = 0;
+  telemetryDropped = 0;
+}
+
+static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc) {
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+    crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+static String slideFilename(uint16_t id) {
+  // The live slide of the running service is served from slideshow.img, everything else from the per-service cache
+  if (snapshot.ServiceStart && id == (snapshot.service[snapshot.ServiceIndex].ServiceID & 0xFFFF) && LittleFS.exists("/slideshow.img")) return "/slideshow.img";
+  return "/" + String(id, HEX) + ".img";
+}
+
+static bool doStartSlide(uint16_t id, size_t offset) {
+  String filename = slideFilename(id);
+  fs::File file = LittleFS.open(filename, "r");
+  if (!file) return false;
+
+  size_t size = file.size();
+  uint8_t buf[SLIDE_CHUNK_SIZE];
+  size_t bytesRead = file.read(buf, sizeof(buf));
+  uint8_t type = 0;
 
-    buffer[buff_size] = '\0';
+  if (bytesRead >= 8 && buf[0] == 0x89 && buf[1] == 0x50 && buf[2] == 0x4E && buf[3] == 0x47 && buf[4] == 0x0D && buf[5] == 0x0A && buf[6] == 0x1A && buf[7] == 0x0A) {
+    type = 2;
+  } else if (bytesRead >= 3 && buf[0] == 0xFF && buf[1] == 0xD8 && buf[2] == 0xFF) {
+    type = 1;
+  }
 
-    file = LittleFS.open("/slideshow.img", "r");
-    uint8_t header[8];
-    size_t bytesRead = file.read(header, sizeof(header));
+  if (type == 0 || offset > size) {
     file.close();
+    return false;
+  }
 
-    if (header[0] == 0x89 && header[1] == 0x50 && header[2] == 0x4E && header[3] == 0x47 && header[4] == 0x0D && header[5] == 0x0A && header[6] == 0x1A && header[7] == 0x0A) {
-      DataPrint("2,");
-    } else if (header[0] == 0xFF && header[1] == 0xD8 && header[2] == 0xFF) {
-      DataPrint("1,");
-    } else {
-      DataPrint("3\n");
-      free(image);
-      free(buffer);
-      radio.SlideShowUpdate2 = false;
-      return;
+  uint32_t crc = crc32(buf, bytesRead, 0);
+  while ((bytesRead = file.read(buf, sizeof(buf))) > 0) crc = crc32(buf, bytesRead, crc);
+  if (!file.seek(offset)) {
+    file.close();
+    return false;
+  }
+
+  if (slide.file) slide.file.close();
+  slide.file = file;
+  slide.active = true;
+  slide.id = id;
+  slide.type = type;
+  slide.live = filename.equals("/slideshow.img");
+  slide.size = size;
+  slide.sent = offset;
+  slide.acked = offset;
+  slide.retries = 0;
+  slide.ackTimer = millis();
+
+  char crcHex[9];
+  snprintf(crcHex, sizeof(crcHex), "%08X", crc);
+  DataPrint("$M=SLIDESHOW=" + String(type) + ",ID=" + String(id, HEX) + ",SIZE=" + String(size) + ",CRC=" + String(crcHex) + ",CHUNK=" + String(SLIDE_CHUNK_SIZE) + "\n");
+  return true;
+}
+
+static void doSlideAck(uint16_t id, size_t offset) {
+  if (!slide.active || id != slide.id || offset > slide.size) return;
+
+  if (offset >= slide.size) {
+    slide.active = false;
+    return;
+  }
+
+  // An ACK below what has been sent means the host lost a chunk: resume from there
+  slide.acked = offset;
+  if (offset < slide.sent) slide.sent = offset;
+  slide.retries = 0;
+  slide.ackTimer = millis();
+}
+
+static void doSlideChunk(void) {
+  if (slide.sent >= slide.size || slide.sent - slide.acked >= (size_t)slideWindow * SLIDE_CHUNK_SIZE) {
+    if (millis() - slide.ackTimer > SLIDE_ACK_TIMEOUT) {
+      if (++slide.retries > SLIDE_ACK_RETRIES) {
+        slide.active = false;
+        DataPrint("$M=SLIDESHOW=3\n");
+        return;
+      }
+      slide.sent = slide.acked;
+      slide.ackTimer = millis();
     }
+    return;
+  }
 
-    DataPrint("BASE64=");
-    DataPrint((char*)buffer);
+  // Only a resend moves the file position, otherwise chunks are read back to back
+  if (slide.file.position() != slide.sent && !slide.file.seek(slide.sent)) {
+    slide.active = false;
+    DataPrint("$M=SLIDESHOW=3\n");
+    return;
+  }
 
-    free(image);
-    free(buffer);
+  uint8_t raw[SLIDE_CHUNK_SIZE];
+  size_t bytesRead = slide.file.read(raw, sizeof(raw));
 
-    DataPrint("\n");
-    radio.SlideShowUpdate2 = false;
+  uint8_t enc[((SLIDE_CHUNK_SIZE + 2) / 3) * 4 + 1];
+  size_t olen = 0;
+  if (bytesRead == 0 || mbedtls_base64_encode(enc, sizeof(enc), &olen, raw, bytesRead) != 0) {
+    slide.active = false;
+    DataPrint("$M=SLIDESHOW=3\n");
+    return;
+  }
+  enc[olen] = '\0';
+
+  char crcHex[9];
+  snprintf(crcHex, sizeof(crcHex), "%08X", crc32(raw, bytesRead, 0));
+  DataPrint("$M=CHUNK=" + String(slide.id, HEX) + "," + String(slide.sent) + "," + String(crcHex) + ",");
+  DataPrint((char*)enc);
+  DataPrint("\n");
+
+  if (slide.sent == slide.acked) slide.ackTimer = millis();
+  slide.sent += bytesRead;
+}
+
+static void doMOTShow(void) {
+  if (radio.SlideShowAvailable && radio.SlideShowUpdate2) {
+    // A new live slide replaces an ongoing transfer of the old one, cached slides are finished first
+    uint16_t id = snapshot.service[snapshot.ServiceIndex].ServiceID & 0xFFFF;
+    if (!slide.active || (slide.id == id && slide.live)) {
+      if (!doStartSlide(id, 0)) DataPrint("$M=SLIDESHOW=3\n");
+      radio.SlideShowUpdate2 = false;
+    }
+  }
+
+  // Transfers end in many places, the file is let go of here
+  if (slide.active) {
+    doSlideChunk();
+  } else if (slide.file) {
+    slide.file.close();
   }
-}
\ No newline at end of file
+}
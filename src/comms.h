@@ -6,8 +6,22 @@
 #include "language.h"
 #include "constants.h"
 #include "si4684.h"
+#include "radiotask.h"
+#include "epg.h"
 #include "mbedtls/base64.h"
 #include <LittleFS.h>
+#include <TimeLib.h>
+
+#define SLIDE_CHUNK_SIZE      510   // Raw bytes per $M=CHUNK line, multiple of 3 so chunks encode without padding
+#define SLIDE_WINDOW_DEFAULT  8     // Unacknowledged chunks in flight
+#define SLIDE_WINDOW_MAX      32
+#define SLIDE_ACK_TIMEOUT     1000
+#define SLIDE_ACK_RETRIES     5
+#define SCAN_LINE_QUEUE       16    // $C lines from the radio task waiting to be printed
+#define TELEMETRY_BATCH_MAX   32
+#define FIG_LINE_MAX          8     // FIGs per $F line
+#define SERVICE_LIST_MAX      (MAX_SERVICES * 58 + 96)  // $L with every label at its longest UTF-8 form
+#define SERVICE_INFO_MAX      128
 
 extern bool ChannelListView;
 extern bool menu;
@@ -15,6 +29,7 @@ extern bool setupmode;
 extern bool ShowServiceInformation;
 extern bool SlideShowView;
 extern bool store;
+extern bool trysetservice;
 extern bool wifi;
 extern byte dabfreq;
 extern byte language;
@@ -28,17 +43,36 @@ extern int InsignificantColorSmooth;
 extern int SignificantColor;
 extern int SignificantColorSmooth;
 extern int16_t SignalLevel;
+extern uint32_t _serviceID;
+extern unsigned long recoverytime;
 
 extern DAB radio;
+extern RadioSnapshot snapshot;
 extern TFT_eSPI tft;
 
 void Communication(void);
 static char hashCommand(String command);
 static void DataPrint(String data);
-static String ServiceList(void);
-static String ServiceInfo(void);
+static void DataWrite(const char* data, size_t length);
+static size_t ServiceList(char* line, size_t size);
+static size_t ServiceInfo(char* line, size_t size);
+static void doDLPlus(const char* tag, uint8_t field);
 static void doEnableConnection(void);
+static void doFIGStream(void);
+static void doTraceDump(void);
+static bool doStartSlide(uint16_t id, size_t offset);
+static String slideFilename(uint16_t id);
+static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc);
 static void doMOTShow(void);
+static void doResetStats(void);
+static void doScan(void);
+static void doScanReport(const ScanResult& result);
+static void doScanLine(const String& line);
+static void doScanEnd(void);
+static void doTelemetry(void);
+static void doTelemetryFrame(void);
+static void doSlideAck(uint16_t id, size_t offset);
+static void doSlideChunk(void);
 static void handleCommunication(void);
 static void outputCommunication(void);
 
@@ -46,4 +80,5 @@ extern void tftPrint(int8_t offset, const String & text, int16_t x, int16_t y, i
 extern void loadFonts(bool option);
 extern void ShowFreq(void);
 extern void BuildDisplay(void);
+extern void setAnnouncements(uint16_t mask);
 #endif
\ No newline at end of file
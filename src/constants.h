@@ -11,6 +11,8 @@
 #define SLBUTTON        26
 #define MODEBUTTON      39
 #define CONTRASTPIN     2
+#define SI4684_SS       15
+#define SI4684_INTB     -1  // Si4684 INTB, -1 when not wired to a GPIO (polled completion)
 
 #define ITEM_GAP        20
 #define ITEM1           3
@@ -27,9 +29,9 @@
 // EEPROM index defines
 #define EE_PRESETS_CNT              99
 #define EE_PRESETS_FREQUENCY        255
-#define EE_CHECKBYTE_VALUE          2 // 0 ~ 255,add new entry, change for new value
+#define EE_CHECKBYTE_VALUE          3 // 0 ~ 255,add new entry, change for new value
 
-#define EE_TOTAL_CNT                2614
+#define EE_TOTAL_CNT                2814
 #define EE_BYTE_CHECKBYTE           0
 #define EE_BYTE_LANGUAGE            1
 #define EE_BYTE_CONTRASTSET         2
@@ -49,6 +51,8 @@
 #define EE_PRESETS_FREQ_START       39
 #define EE_PRESETS_SERVICEID_START  138
 #define EE_PRESETS_NAME_START       930
+#define EE_UINT16_ANNOUNCE          2614
+#define EE_PRESETS_ANNOUNCE_START   2616
 // End of EEPROM index defines
 
 static const char* const unitString[] = {"dBμV", "dBf", "dBm"};
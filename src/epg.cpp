@@ -0,0 +1,396 @@
+#include "epg.h"
+#include <TimeLib.h>
+
+#define STATE_IDLE        0
+#define STATE_TAG         1
+#define STATE_LENGTH      2
+#define STATE_LENGTH_EXT  3
+#define STATE_VALUE       4
+#define STATE_SKIP        5
+
+// ETSI TS 102 371 element and attribute tags, only the ones the schedule needs
+#define TAG_CDATA         0x01
+#define TAG_EPG           0x02
+#define TAG_INFORMATION   0x03
+#define TAG_SHORTNAME     0x10
+#define TAG_MEDIUMNAME    0x11
+#define TAG_LONGNAME      0x12
+#define TAG_LOCATION      0x19
+#define TAG_PROGRAMME     0x1C
+#define TAG_SCHEDULE      0x21
+#define TAG_SERVICESCOPE  0x25
+#define TAG_TIME          0x2C
+#define TAG_BEARER        0x2D
+#define ATTR_ID           0x80
+#define ATTR_TIME         0x80
+#define ATTR_DURATION     0x81
+
+uint8_t epgState;
+uint32_t epgPos;
+uint8_t epgTag[EPG_DEPTH];
+uint32_t epgEnd[EPG_DEPTH];
+uint8_t epgDepth;
+uint8_t epgToken;
+uint32_t epgLength;
+uint8_t epgLengthBytes;
+uint32_t epgValueEnd;
+uint8_t epgValue[EPG_VALUE_SIZE];
+uint8_t epgValueLength;
+uint32_t epgDefault;
+uint32_t epgScope;
+int32_t epgOffset;
+EPGProgramme epgCurrent;
+uint32_t epgCurrentService;
+uint8_t epgNameRank;
+bool epgTimeDone;
+EPGProgramme epgBatch[EPG_BATCH];
+uint32_t epgBatchService[EPG_BATCH];
+uint8_t epgBatchCount;
+volatile uint32_t epgGeneration;
+bool epgMemoValid;
+bool epgMemoFound;
+uint32_t epgMemoService;
+uint32_t epgMemoMinute;
+uint32_t epgMemoGeneration;
+EPGProgramme epgMemoNow;
+EPGProgramme epgMemoNext;
+
+static bool epgOpen(void);
+static void epgClose(void);
+static bool epgWanted(void);
+static void epgLeaf(void);
+static void epgStartElement(uint8_t tag);
+static void epgEndElement(uint8_t tag);
+static void epgFlush(void);
+static void epgMerge(uint32_t ServiceID, const EPGProgramme* batch, uint8_t count);
+static bool epgLookup(uint32_t ServiceID, uint32_t time, EPGProgramme& now, EPGProgramme& next);
+static uint32_t epgTime(const uint8_t* value, uint8_t length);
+static uint32_t epgServiceID(const uint8_t* value, uint8_t length);
+static String epgFilename(uint32_t ServiceID);
+
+// Start of a new EPG object, programmes without a scope or bearer of their own belong to ServiceID
+void epgBegin(uint32_t ServiceID) {
+  epgState = STATE_TAG;
+  epgPos = 0;
+  epgDepth = 0;
+  epgDefault = ServiceID;
+  epgScope = 0;
+}
+
+// Tokenize the next data group chunk as it arrives, only the values the schedule needs are ever held in RAM
+bool epgFeed(const uint8_t* data, uint16_t length) {
+  uint16_t i = 0;
+  while (i < length) {
+    switch (epgState) {
+      case STATE_IDLE:
+        return true;
+
+      case STATE_TAG:
+        epgToken = data[i++];
+        epgPos++;
+        epgState = STATE_LENGTH;
+        break;
+
+      case STATE_LENGTH:
+        epgPos++;
+        if (data[i] == 0xFE || data[i] == 0xFF) {
+          epgLengthBytes = (data[i] == 0xFE) ? 2 : 3;
+          epgLength = 0;
+          epgState = STATE_LENGTH_EXT;
+          i++;
+        } else {
+          epgLength = data[i++];
+          if (!epgOpen()) return false;
+        }
+        break;
+
+      case STATE_LENGTH_EXT:
+        epgPos++;
+        epgLength = (epgLength << 8) | data[i++];
+        if (--epgLengthBytes == 0 && !epgOpen()) return false;
+        break;
+
+      case STATE_VALUE:
+      case STATE_SKIP: {
+        uint32_t count = min((uint32_t)(length - i), epgValueEnd - epgPos);
+        if (epgState == STATE_VALUE) {
+          uint8_t keep = min(count, (uint32_t)(EPG_VALUE_SIZE - epgValueLength));
+          memcpy(&epgValue[epgValueLength], &data[i], keep);
+          epgValueLength += keep;
+        }
+        i += count;
+        epgPos += count;
+        if (epgPos == epgValueEnd) {
+          if (epgState == STATE_VALUE) epgLeaf();
+          epgState = STATE_TAG;
+          epgClose();
+        }
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+// A broken object keeps the programmes it already completed
+void epgAbort(void) {
+  epgState = STATE_IDLE;
+  if (epgBatchCount > 0) epgFlush();
+}
+
+// Memoized per minute, the GUI asks every loop
+bool epgNowNext(uint32_t ServiceID, uint32_t time, EPGProgramme& now, EPGProgramme& next) {
+  if (!epgMemoValid || ServiceID != epgMemoService || time / 60 != epgMemoMinute || epgGeneration != epgMemoGeneration) {
+    epgMemoValid = true;
+    epgMemoService = ServiceID;
+    epgMemoMinute = time / 60;
+    epgMemoGeneration = epgGeneration;
+    epgMemoFound = epgLookup(ServiceID, time, epgMemoNow, epgMemoNext);
+  }
+  now = epgMemoNow;
+  next = epgMemoNext;
+  return epgMemoFound;
+}
+
+static bool epgOpen(void) {
+  uint32_t end = epgPos + epgLength;
+  if (epgDepth > 0 && end > epgEnd[epgDepth - 1]) {
+    epgAbort();
+    return false;
+  }
+
+  // Service information objects and anything else that is not a schedule are not decoded
+  if (epgDepth == 0 && epgToken != TAG_EPG) {
+    epgState = STATE_IDLE;
+    return true;
+  }
+
+  bool element = epgToken == TAG_EPG || epgToken == TAG_INFORMATION || (epgToken >= 0x10 && epgToken < 0x80);
+  if (element && epgDepth < EPG_DEPTH) {
+    epgTag[epgDepth] = epgToken;
+    epgEnd[epgDepth] = end;
+    epgDepth++;
+    epgStartElement(epgToken);
+    epgState = STATE_TAG;
+    epgClose();
+  } else if (epgLength == 0) {
+    epgState = STATE_TAG;
+    epgClose();
+  } else {
+    epgValueEnd = end;
+    epgValueLength = 0;
+    epgState = (!element && epgWanted()) ? STATE_VALUE : STATE_SKIP;
+  }
+  return true;
+}
+
+static void epgClose(void) {
+  while (epgDepth > 0 && epgPos >= epgEnd[epgDepth - 1]) {
+    epgDepth--;
+    epgEndElement(epgTag[epgDepth]);
+  }
+}
+
+static bool epgWanted(void) {
+  uint8_t parent = epgTag[epgDepth - 1];
+  bool programme = epgDepth >= 2 && epgTag[epgDepth - 2] == TAG_PROGRAMME;
+  bool located = epgDepth >= 3 && epgTag[epgDepth - 2] == TAG_LOCATION && epgTag[epgDepth - 3] == TAG_PROGRAMME;
+
+  if (epgToken == TAG_CDATA) return programme && parent >= TAG_SHORTNAME && parent <= TAG_LONGNAME;
+  if (parent == TAG_TIME) return located && !epgTimeDone && (epgToken == ATTR_TIME || epgToken == ATTR_DURATION);
+  if (parent == TAG_BEARER) return located && epgToken == ATTR_ID;
+  return parent == TAG_SERVICESCOPE && epgToken == ATTR_ID;
+}
+
+static void epgLeaf(void) {
+  uint8_t parent = epgTag[epgDepth - 1];
+
+  if (epgToken == TAG_CDATA) {
+    // Medium names fit the display best, then long names cut short, then short names
+    uint8_t rank = (parent == TAG_MEDIUMNAME) ? 3 : (parent == TAG_LONGNAME) ? 2 : 1;
+    if (rank <= epgNameRank) return;
+    epgNameRank = rank;
+
+    uint8_t length = 0;
+    for (uint8_t x = 0; x < epgValueLength && length < sizeof(epgCurrent.Name) - 1; x++) {
+      if (epgValue[x] >= 0x20) epgCurrent.Name[length++] = epgValue[x];  // Token references are dropped
+    }
+
+    // Never end on half a UTF-8 sequence
+    uint8_t lead = length;
+    while (lead > 0 && (epgCurrent.Name[lead - 1] & 0xC0) == 0x80) lead--;
+    if (lead > 0 && (epgCurrent.Name[lead - 1] & 0x80)) {
+      uint8_t first = epgCurrent.Name[lead - 1];
+      uint8_t size = ((first & 0xE0) == 0xC0) ? 2 : ((first & 0xF0) == 0xE0) ? 3 : 4;
+      if (length - (lead - 1) < size) length = lead - 1;
+    }
+    epgCurrent.Name[length] = '\0';
+  } else if (parent == TAG_TIME && epgToken == ATTR_TIME) {
+    epgCurrent.Start = epgTime(epgValue, epgValueLength);
+  } else if (parent == TAG_TIME && epgToken == ATTR_DURATION) {
+    epgCurrent.Duration = 0;
+    for (uint8_t x = 0; x < epgValueLength && x < 4; x++) epgCurrent.Duration = (epgCurrent.Duration << 8) | epgValue[x];
+  } else if (parent == TAG_BEARER) {
+    if (epgCurrentService == 0) epgCurrentService = epgServiceID(epgValue, epgValueLength);
+  } else if (parent == TAG_SERVICESCOPE) {
+    if (epgScope == 0) epgScope = epgServiceID(epgValue, epgValueLength);
+  }
+}
+
+static void epgStartElement(uint8_t tag) {
+  if (tag == TAG_PROGRAMME) {
+    memset(&epgCurrent, 0, sizeof(epgCurrent));
+    epgCurrentService = 0;
+    epgNameRank = 0;
+    epgTimeDone = false;
+  } else if (tag == TAG_SCHEDULE) {
+    epgScope = 0;
+  }
+}
+
+static void epgEndElement(uint8_t tag) {
+  switch (tag) {
+    case TAG_TIME:
+      if (epgCurrent.Start != 0) epgTimeDone = true;
+      break;
+
+    case TAG_PROGRAMME:
+      if (epgCurrent.Start == 0 || epgCurrent.Name[0] == '\0') break;
+      epgBatch[epgBatchCount] = epgCurrent;
+      epgBatchService[epgBatchCount] = (epgCurrentService != 0) ? epgCurrentService : (epgScope != 0) ? epgScope : epgDefault;
+      if (++epgBatchCount == EPG_BATCH) epgFlush();
+      break;
+
+    case TAG_EPG:
+      epgState = STATE_IDLE;
+      if (epgBatchCount > 0) epgFlush();
+      break;
+  }
+}
+
+static void epgFlush(void) {
+  // Group by service and order on start time, the batch is small enough for an insertion sort
+  for (uint8_t x = 1; x < epgBatchCount; x++) {
+    EPGProgramme entry = epgBatch[x];
+    uint32_t service = epgBatchService[x];
+    int8_t y = x - 1;
+    while (y >= 0 && (epgBatchService[y] > service || (epgBatchService[y] == service && epgBatch[y].Start > entry.Start))) {
+      epgBatch[y + 1] = epgBatch[y];
+      epgBatchService[y + 1] = epgBatchService[y];
+      y--;
+    }
+    epgBatch[y + 1] = entry;
+    epgBatchService[y + 1] = service;
+  }
+
+  uint8_t first = 0;
+  for (uint8_t x = 1; x <= epgBatchCount; x++) {
+    if (x == epgBatchCount || epgBatchService[x] != epgBatchService[first]) {
+      if (epgBatchService[first] != 0) epgMerge(epgBatchService[first], &epgBatch[first], x - first);
+      first = x;
+    }
+  }
+  epgBatchCount = 0;
+  epgGeneration++;
+}
+
+// Merge a sorted batch into the service file in one pass, dropping what has finished and what was rebroadcast
+static void epgMerge(uint32_t ServiceID, const EPGProgramme* batch, uint8_t count) {
+  File out = LittleFS.open("/epg.tmp", "w");
+  if (!out) return;
+  File in = LittleFS.open(epgFilename(ServiceID), "r");
+
+  uint32_t expired = (now() > EPG_KEEP) ? now() - EPG_KEEP : 0;
+  EPGProgramme stored;
+  bool have = in && in.read((uint8_t*)&stored, sizeof(stored)) == sizeof(stored);
+  uint8_t x = 0;
+  uint16_t written = 0;
+  bool ok = true;
+
+  while (ok && written < EPG_MAX_PROGRAMMES && (have || x < count)) {
+    EPGProgramme entry;
+    if (have && (x >= count || stored.Start < batch[x].Start)) {
+      entry = stored;
+      have = in.read((uint8_t*)&stored, sizeof(stored)) == sizeof(stored);
+    } else {
+      if (have && stored.Start == batch[x].Start) have = in.read((uint8_t*)&stored, sizeof(stored)) == sizeof(stored);
+      entry = batch[x++];
+      if (x < count && batch[x].Start == entry.Start) continue;
+    }
+    if (entry.Start + entry.Duration < expired) continue;
+    ok = out.write((const uint8_t*)&entry, sizeof(entry)) == sizeof(entry);
+    written++;
+  }
+  if (in) in.close();
+  out.close();
+
+  if (!ok) {
+    LittleFS.remove("/epg.tmp");
+    return;
+  }
+  LittleFS.rename("/epg.tmp", epgFilename(ServiceID));
+}
+
+// Binary search on the fixed size records for the last programme that started by time
+static bool epgLookup(uint32_t ServiceID, uint32_t time, EPGProgramme& now, EPGProgramme& next) {
+  memset(&now, 0, sizeof(now));
+  memset(&next, 0, sizeof(next));
+
+  File file = LittleFS.open(epgFilename(ServiceID), "r");
+  if (!file) return false;
+
+  uint16_t count = file.size() / sizeof(EPGProgramme);
+  uint16_t low = 0;
+  uint16_t high = count;
+  EPGProgramme entry;
+  while (low < high) {
+    uint16_t mid = (low + high) / 2;
+    file.seek(mid * sizeof(EPGProgramme));
+    if (file.read((uint8_t*)&entry, sizeof(entry)) != sizeof(entry)) break;
+    if (entry.Start <= time) low = mid + 1; else high = mid;
+  }
+
+  if (low > 0) {
+    file.seek((low - 1) * sizeof(EPGProgramme));
+    if (file.read((uint8_t*)&entry, sizeof(entry)) == sizeof(entry) && entry.Start + entry.Duration > time) now = entry;
+  }
+  if (low < count) {
+    file.seek(low * sizeof(EPGProgramme));
+    if (file.read((uint8_t*)&entry, sizeof(entry)) == sizeof(entry)) next = entry;
+  }
+  file.close();
+  return now.Start != 0 || next.Start != 0;
+}
+
+// timePoint: rfu, 17 bit MJD, rfu, LTO flag, UTC flag, hours and minutes, seconds and ms in the long form, then the LTO
+static uint32_t epgTime(const uint8_t* value, uint8_t length) {
+  if (length < 4) return 0;
+  uint32_t mjd = ((uint32_t)(value[0] & 0x7F) << 10) | ((uint32_t)value[1] << 2) | (value[2] >> 6);
+  bool lto = bitRead(value[2], 4);
+  bool utc = bitRead(value[2], 3);
+  uint8_t hours = ((value[2] & 0x07) << 2) | (value[3] >> 6);
+  uint8_t minutes = value[3] & 0x3F;
+  uint8_t seconds = (utc && length >= 6) ? (value[4] >> 2) : 0;
+  uint8_t offset = utc ? 6 : 4;
+
+  // Times are kept on the local clock the GUI shows, an object without LTO uses the last one seen
+  if (lto && length > offset) epgOffset = (bitRead(value[offset], 5) ? -1 : 1) * (int32_t)(value[offset] & 0x1F) * 1800;
+  if (mjd < 40587) return 0;
+  return (mjd - 40587) * 86400 + hours * 3600 + minutes * 60 + seconds + epgOffset;
+}
+
+// contentId: flags, ECC and EId when the ensemble flag is set, then a 16 or 32 bit SId
+static uint32_t epgServiceID(const uint8_t* value, uint8_t length) {
+  if (length < 3) return 0;
+  uint8_t offset = bitRead(value[0], 6) ? 4 : 1;
+  uint8_t size = bitRead(value[0], 4) ? 4 : 2;
+  if (offset + size > length) return 0;
+
+  uint32_t sid = 0;
+  for (uint8_t x = 0; x < size; x++) sid = (sid << 8) | value[offset + x];
+  return sid;
+}
+
+static String epgFilename(uint32_t ServiceID) {
+  return "/epg_" + String(ServiceID, HEX) + ".db";
+}
@@ -0,0 +1,26 @@
+#ifndef epg_h
+#define epg_h
+
+#include "Arduino.h"
+#include <FS.h>
+#include <LittleFS.h>
+
+#define EPG_DEPTH           8     // Element nesting the tokenizer follows, anything deeper is skipped whole
+#define EPG_VALUE_SIZE      48    // Attribute or CDATA bytes kept, the rest of a longer value is skipped
+#define EPG_BATCH           32    // Programmes collected before they are merged into their service file
+#define EPG_MAX_PROGRAMMES  192   // Per service file, later programmes are dropped once it is full
+#define EPG_KEEP            3600  // s a finished programme stays in its file
+
+// One /epg_<SId>.db file per service, fixed size records sorted on Start
+typedef struct __attribute__((packed)) _EPGProgramme {
+  uint32_t  Start;            // Local time, same clock as TimeLib now()
+  uint32_t  Duration;         // s
+  char      Name[33];         // UTF-8
+} EPGProgramme;
+
+void epgBegin(uint32_t ServiceID);
+bool epgFeed(const uint8_t* data, uint16_t length);
+void epgAbort(void);
+bool epgNowNext(uint32_t ServiceID, uint32_t time, EPGProgramme& now, EPGProgramme& next);
+
+#endif
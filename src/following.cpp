@@ -0,0 +1,53 @@
+#include "following.h"
+
+extern DAB radio;
+
+bool following;
+unsigned long followBadSince;
+unsigned long followNext;
+uint16_t FollowSwitches;
+unsigned long FollowTime;
+
+void followEnable(bool enable) {
+  following = enable;
+  radio.FICDecode = enable || radio.AnnouncementMask != 0;
+  followReset();
+}
+
+bool followEnabled(void) {
+  return following;
+}
+
+void followReset(void) {
+  followBadSince = 0;
+  followNext = millis() + FOLLOW_HOLDOFF;
+}
+
+// Scores the running service, returns the channels to try once it has been bad for long enough
+uint8_t followCheck(uint8_t channel, uint8_t* candidates) {
+  if (!following || !radio.ServiceStart || (long)(millis() - followNext) < 0) return 0;
+
+  if (radio.signallock && radio.fic >= FOLLOW_GOOD_FIC) {
+    followBadSince = 0;
+    return 0;
+  }
+  if (radio.signallock && radio.fic >= FOLLOW_BAD_FIC) return 0;
+
+  if (followBadSince == 0) followBadSince = millis();
+  if (millis() - followBadSince < FOLLOW_BAD_TIME) return 0;
+  followReset();
+
+  // FIC first, then the multiplex database for ensembles the FIC does not mention
+  uint32_t ServiceID = radio.service[radio.ServiceIndex].ServiceID;
+  uint8_t count = radio.getAlternatives(ServiceID, candidates, FOLLOW_CANDIDATES);
+  for (uint8_t x = 0; x < MUXDB_CHANNELS && count < FOLLOW_CANDIDATES; x++) {
+    bool listed = (x == channel);
+    for (uint8_t c = 0; c < count; c++) if (candidates[c] == x) listed = true;
+    if (!listed && muxdbHasService(x, ServiceID)) candidates[count++] = x;
+  }
+
+  // The tuned channel is never an alternative to itself
+  uint8_t kept = 0;
+  for (uint8_t c = 0; c < count; c++) if (candidates[c] != channel) candidates[kept++] = candidates[c];
+  return kept;
+}
@@ -0,0 +1,23 @@
+#ifndef following_h
+#define following_h
+
+#include "Arduino.h"
+#include "si4684.h"
+#include "muxdb.h"
+#include "scanner.h"
+
+#define FOLLOW_BAD_FIC      40    // FIC quality below this counts as a failing signal
+#define FOLLOW_GOOD_FIC     70    // and above this as a good one again, in between nothing changes
+#define FOLLOW_BAD_TIME     3000  // ms the signal has to stay bad before alternatives are tried
+#define FOLLOW_HOLDOFF      30000 // ms after a check before the next one
+#define FOLLOW_CANDIDATES   SCAN_LIST_SIZE
+
+extern uint16_t FollowSwitches;
+extern unsigned long FollowTime;
+
+void followEnable(bool enable);
+bool followEnabled(void);
+uint8_t followCheck(uint8_t channel, uint8_t* candidates);
+void followReset(void);
+
+#endif
@@ -164,15 +164,15 @@ void ShowServiceInfo(void) {
   tftPrint(-1, String(radio.getChannel(dabfreq)) + " - " + String(radio.getFreq(dabfreq) / 1000) + "." + (radio.getFreq(dabfreq) % 1000 < 100 ? "0" : "") + String(radio.getFreq(dabfreq) % 1000) + " MHz", 166, 36, PrimaryColor, PrimaryColorSmooth, 16);
   tftPrint(-1, String(unitString[unit]) + "  MER:", 193, 56, PrimaryColor, PrimaryColorSmooth, 16);
   tftPrint(-1, "dB", 286, 56, PrimaryColor, PrimaryColorSmooth, 16);
-  tftPrint(-1, radio.ASCII(radio.EnsembleLabel, radio.EnsembleLabelCharset), 166, 76, PrimaryColor, PrimaryColorSmooth, 16);
-  tftPrint(-1, radio.ASCII(radio.service[radio.ServiceIndex].Label, radio.ServiceLabelCharset), 166, 96, PrimaryColor, PrimaryColorSmooth, 16);
-  tftPrint(-1, String(radio.pty, DEC) + ": " + String(myLanguage[language][37 + radio.pty]), 166, 116, PrimaryColor, PrimaryColorSmooth, 16);
-  tftPrint(-1, ProtectionText[radio.protectionlevel], 166, 136, PrimaryColor, PrimaryColorSmooth, 16);
-  String bitrateString = String(radio.samplerate);
+  tftPrint(-1, radio.label(snapshot.EnsembleLabel, snapshot.EnsembleLabelCharset), 166, 76, PrimaryColor, PrimaryColorSmooth, 16);
+  tftPrint(-1, radio.label(snapshot.service[snapshot.ServiceIndex].Label, snapshot.ServiceLabelCharset), 166, 96, PrimaryColor, PrimaryColorSmooth, 16);
+  tftPrint(-1, String(snapshot.pty, DEC) + ": " + String(myLanguage[language][37 + snapshot.pty]), 166, 116, PrimaryColor, PrimaryColorSmooth, 16);
+  tftPrint(-1, ProtectionText[snapshot.protectionlevel], 166, 136, PrimaryColor, PrimaryColorSmooth, 16);
+  String bitrateString = String(snapshot.samplerate);
   bitrateString = bitrateString.substring(0, 2) + "." + bitrateString.substring(2);
   tftPrint(-1, bitrateString + " Hz", 166, 156, PrimaryColor, PrimaryColorSmooth, 16);
-  tftPrint(-1, String(radio.bitrate, DEC) + " kb/s", 166, 176, PrimaryColor, PrimaryColorSmooth, 16);
-  tftPrint(-1, String(ServiceTypeText[radio.servicetype]) + " - " + AudioModeText[radio.audiomode], 166, 196, PrimaryColor, PrimaryColorSmooth, 16);
+  tftPrint(-1, String(snapshot.bitrate, DEC) + " kb/s", 166, 176, PrimaryColor, PrimaryColorSmooth, 16);
+  tftPrint(-1, String(ServiceTypeText[snapshot.servicetype]) + " - " + AudioModeText[snapshot.audiomode], 166, 196, PrimaryColor, PrimaryColorSmooth, 16);
 }
 
 void BuildChannelList(void) {
@@ -180,41 +180,29 @@ void BuildChannelList(void) {
   tft.pushImage (0, 0, 320, 240, servicelistbackground);
   tftPrint(0, myLanguage[language][11], 155, 4, ActiveColor, ActiveColorSmooth, 28);
 
-  byte y = 0;
-  if (radio.ServiceIndex > 8 && radio.ServiceIndex < 17) {
-    y = 9;
-  } else if (radio.ServiceIndex > 16 && radio.ServiceIndex < 25) {
-    y = 17;
-  } else if (radio.ServiceIndex > 24) {
-    y = 25;
-  }
+  byte y = ChannelListTop(snapshot.ServiceIndex);
 
-  if (radio.numberofservices > 8) {
-    byte z = 0;
-    if (radio.numberofservices < 17) {
-      z = 2;
-    } else if (radio.numberofservices < 25) {
-      z = 3;
-    } else if (radio.numberofservices > 24) {
-      z = 4;
-    }
-    if (y == 0) {
-      tftPrint(0, "1/" + String(z), 290, 10, SecondaryColor, SecondaryColorSmooth, 16);
-    } else if (y == 9) {
-      tftPrint(0, "2/" + String(z), 290, 10, SecondaryColor, SecondaryColorSmooth, 16);
-    } else if (y == 17) {
-      tftPrint(0, "3/" + String(z), 290, 10, SecondaryColor, SecondaryColorSmooth, 16);
-    } else if (y == 25) {
-      tftPrint(0, "4/" + String(z), 290, 10, SecondaryColor, SecondaryColorSmooth, 16);
-    }
+  if (snapshot.numberofservices > 9) {
+    byte z = ChannelListPage(snapshot.numberofservices - 1) + 1;
+    tftPrint(0, String(ChannelListPage(snapshot.ServiceIndex) + 1) + "/" + String(z), 290, 10, SecondaryColor, SecondaryColorSmooth, 16);
   }
 
-  for (byte i = y; i < radio.numberofservices; i++) {
-    ShowOneLine(20 * (i - y), i, (radio.ServiceIndex - y == i - y ? true : false));
+  for (byte i = y; i < snapshot.numberofservices; i++) {
+    ShowOneLine(20 * (i - y), i, (snapshot.ServiceIndex - y == i - y ? true : false));
     if (i - y == 8) i = 254;
   }
 }
 
+// The first page holds services 0-8, every page after that eight more
+byte ChannelListPage(byte index) {
+  return (index > 8) ? (index - 1) / 8 : 0;
+}
+
+byte ChannelListTop(byte index) {
+  byte page = ChannelListPage(index);
+  return (page == 0) ? 0 : 1 + page * 8;
+}
+
 void ShowOneLine(byte position, byte item, bool selected) {
   if (ChannelListView) {
     FullLineSprite.pushImage (-8, -position - 35, 320, 240, servicelistbackground);
@@ -222,9 +210,9 @@ void ShowOneLine(byte position, byte item, bool selected) {
 
     FullLineSprite.setTextColor(SecondaryColor, SecondaryColorSmooth, false);
     FullLineSprite.setTextDatum(TL_DATUM);
-    FullLineSprite.drawString(String(radio.service[item].CompID & 0xFF, DEC), 12, 3);
+    FullLineSprite.drawString(String(snapshot.service[item].CompID & 0xFF, DEC), 12, 3);
 
-    String serviceIDString = String(radio.service[item].ServiceID & 0xFFFF, HEX);
+    String serviceIDString = String(snapshot.service[item].ServiceID & 0xFFFF, HEX);
     while (serviceIDString.length() < 4) serviceIDString = "0" + serviceIDString;
     serviceIDString.toUpperCase();
     FullLineSprite.setTextDatum(TC_DATUM);
@@ -232,11 +220,11 @@ void ShowOneLine(byte position, byte item, bool selected) {
 
     FullLineSprite.setTextColor(PrimaryColor, PrimaryColorSmooth, false);
     FullLineSprite.setTextDatum(TL_DATUM);
-    FullLineSprite.drawString(String(radio.ASCII(radio.service[item].Label, radio.ServiceLabelCharset)), 84, 3);
+    FullLineSprite.drawString(radio.label(snapshot.service[item].Label, snapshot.ServiceLabelCharset), 84, 3);
 
     FullLineSprite.setTextDatum(TC_DATUM);
     FullLineSprite.setTextColor(SecondaryColor, SecondaryColorSmooth, false);
-    FullLineSprite.drawString(ServiceTypeText[radio.service[item].ServiceType], 282, 3);
+    FullLineSprite.drawString(ServiceTypeText[snapshot.service[item].ServiceType], 282, 3);
     FullLineSprite.pushSprite(8, 35 + position);
   } else if (menu) {
     FullLineSprite.pushImage (-8, -position - 32, 320, 240, configurationbackground);
@@ -659,14 +647,14 @@ void ShowFreq(void) {
 }
 
 void ShowPTY(void) {
-  if (!radio.ServiceStart) radio.pty = 36;
-  if (radio.pty != ptyold || displayreset) {
+  if (!snapshot.ServiceStart) snapshot.pty = 36;
+  if (snapshot.pty != ptyold || displayreset) {
     LongSprite.pushImage(-8, -162, 320, 240, Background);
     LongSprite.setTextDatum(TC_DATUM);
     LongSprite.setTextColor(SecondaryColor, SecondaryColorSmooth, false);
-    LongSprite.drawString(myLanguage[language][37 + radio.pty], 75, 0);
+    LongSprite.drawString(myLanguage[language][37 + snapshot.pty], 75, 0);
     LongSprite.pushSprite(8, 162);
-    ptyold = radio.pty;
+    ptyold = snapshot.pty;
   }
 }
 
@@ -679,13 +667,29 @@ void ShowRT(void) {
     FullLineSprite.pushImage(-6, -220, 320, 240, Background);
   }
 
+  // Artist and title from DL Plus when tagged, else the radiotext, else what the EPG has on now and next
+  static uint16_t DLPlusGenerationOld;
+  static char nowPlaying[TEXT_TEXT_SIZE];
+  if (snapshot.DLPlusGeneration != DLPlusGenerationOld) {
+    DLPlusGenerationOld = snapshot.DLPlusGeneration;
+    nowPlaying[0] = '\0';
+    if (snapshot.DLPlus[DLPLUS_ARTIST].Length > 0 && snapshot.DLPlus[DLPLUS_TITLE].Length > 0) {
+      size_t length = snprintf(nowPlaying, sizeof(nowPlaying), "%s - ", radio.DLPlusText(snapshot.ServiceData, snapshot.DLPlus[DLPLUS_ARTIST], snapshot.ServiceLabelCharset));
+      if (length < sizeof(nowPlaying)) snprintf(nowPlaying + length, sizeof(nowPlaying) - length, "%s", radio.DLPlusText(snapshot.ServiceData, snapshot.DLPlus[DLPLUS_TITLE], snapshot.ServiceLabelCharset));
+    }
+  }
+
+  const char* text = nowPlaying;
+  if (text[0] == '\0') text = radio.label(snapshot.ServiceData, snapshot.ServiceLabelCharset, sizeof(snapshot.ServiceData));
+  if (text[0] == '\0') text = EPGText();
+
   FullLineSprite.setTextColor(PrimaryColor, PrimaryColorSmooth, false);
-  if (radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset).length() > 0) {
-    RTWidth = tft.textWidth(radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset));
+  if (text[0] != '\0') {
+    RTWidth = tft.textWidth(text);
     if (RTWidth < 300) {
       xPos = 0;
       FullLineSprite.setTextDatum(TC_DATUM);
-      FullLineSprite.drawString(String(radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset)), 154, 1);
+      FullLineSprite.drawString(text, 154, 1);
       FullLineSprite.pushSprite(6, 219);
     } else {
       if (millis() - rtticker >= 20) {
@@ -694,8 +698,8 @@ void ShowRT(void) {
 
         if (xPos < -RTWidth - 50) xPos = 0;
         FullLineSprite.setTextDatum(TL_DATUM);
-        FullLineSprite.drawString(String(radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset)), xPos, 1);
-        FullLineSprite.drawString(String(radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset)), xPos + RTWidth + 50, 1);
+        FullLineSprite.drawString(text, xPos, 1);
+        FullLineSprite.drawString(text, xPos + RTWidth + 50, 1);
         FullLineSprite.pushSprite(6, 219);
         rtticker = millis();
       }
@@ -703,126 +707,157 @@ void ShowRT(void) {
   } else {
     FullLineSprite.pushSprite(6, 220);
   }
-  if (RTold != radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset)) xPos = 0;
-  RTold = radio.ASCII(radio.ServiceData, radio.ServiceLabelCharset);
+  if (RTold != text) {
+    xPos = 0;
+    RTold = text;
+  }
+}
+
+// Rebuilt only when the programmes change, ShowRT asks every loop
+const char* EPGText(void) {
+  static char text[96];
+  static uint32_t serviceOld;
+  static uint32_t currentOld;
+  static uint32_t nextOld;
+  EPGProgramme current;
+  EPGProgramme next;
+  uint32_t sid = snapshot.service[snapshot.ServiceIndex].ServiceID;
+  if (!snapshot.ServiceStart || !epgNowNext(sid, now(), current, next)) return "";
+  if (sid == serviceOld && current.Start == currentOld && next.Start == nextOld) return text;
+
+  serviceOld = sid;
+  currentOld = current.Start;
+  nextOld = next.Start;
+  text[0] = '\0';
+  if (current.Start != 0) strncpy(text, current.Name, sizeof(text) - 1);
+  if (next.Start != 0) {
+    size_t length = strlen(text);
+    snprintf(&text[length], sizeof(text) - length, "%s%02d:%02d %s", length > 0 ? "  >  " : "", hour(next.Start), minute(next.Start), next.Name);
+  }
+  return text;
 }
 
 void ShowSID(void) {
-  if (!radio.ServiceStart) radio.SID[0] = '\0';
-  if (String(radio.SID) != SIDold || displayreset) {
+  if (!snapshot.ServiceStart) snapshot.SID[0] = '\0';
+  if (SIDold != snapshot.SID || displayreset) {
     ShortSprite.pushImage(-38, -120, 320, 240, Background);
     ShortSprite.setTextDatum(TL_DATUM);
     ShortSprite.setTextColor(SecondaryColor, SecondaryColorSmooth, false);
-    ShortSprite.drawString(String(radio.SID), 0, 0);
+    ShortSprite.drawString(String(snapshot.SID), 0, 0);
     ShortSprite.pushSprite(38, 120);
-    SIDold = String(radio.SID);
+    SIDold = String(snapshot.SID);
   }
 }
 
 void ShowEID(void) {
-  if (tuning) radio.EID[0] = '\0';
-  if (String(radio.EID) != EIDold || displayreset) {
+  if (tuning) snapshot.EID[0] = '\0';
+  if (EIDold != snapshot.EID || displayreset) {
     ShortSprite.pushImage(-38, -106, 320, 240, Background);
     ShortSprite.setTextDatum(TL_DATUM);
     ShortSprite.setTextColor(SecondaryColor, SecondaryColorSmooth, false);
-    ShortSprite.drawString(String(radio.EID), 0, 0);
+    ShortSprite.drawString(String(snapshot.EID), 0, 0);
     ShortSprite.pushSprite(38, 106);
-    EIDold = String(radio.EID);
+    EIDold = String(snapshot.EID);
   }
 }
 
 void ShowPS(void) {
-  if (tunemode != TUNE_MEM && !radio.ServiceStart && !tuning && !seek) {
-    if (radio.signallock && !radio.ServiceStart) {
-      strncpy(_serviceName, (radio.numberofservices > 0 ? myLanguage[language][74] : myLanguage[language][73]), sizeof(_serviceName));
+  if (tunemode != TUNE_MEM && !snapshot.ServiceStart && !tuning && !seek) {
+    if (snapshot.signallock && !snapshot.ServiceStart) {
+      strncpy(_serviceName, (snapshot.numberofservices > 0 ? myLanguage[language][74] : myLanguage[language][73]), sizeof(_serviceName));
       _serviceName[sizeof(_serviceName) - 1] = '\0';
-    } else if (radio.signallock && radio.ServiceStart) {
+    } else if (snapshot.signallock && snapshot.ServiceStart) {
       for (byte x = 0; x < 16; x++) _serviceName[x] = '\0';
     } else if (!trysetservice) {
       for (byte x = 0; x < 16; x++) _serviceName[x] = '\0';
     }
   } else if (tunemode != TUNE_MEM && !tuning) {
-    strcpy(_serviceName, radio.service[radio.ServiceIndex].Label);
+    memcpy(_serviceName, snapshot.service[snapshot.ServiceIndex].Label, sizeof(_serviceName));
   }
 
-  if ((radio.ServiceStart ? radio.ASCII(radio.service[radio.ServiceIndex].Label, radio.ServiceLabelCharset) : radio.ASCII(_serviceName, radio.ServiceLabelCharset)) != PSold || displayreset) {
-    if (tunemode != TUNE_MEM || (tunemode == TUNE_MEM && String((radio.signallock && radio.ServiceStart ? radio.ASCII(radio.PStext, radio.ServiceLabelCharset) : radio.ASCII(_serviceName, radio.ServiceLabelCharset))).length() != 0)) {
+  const char* name = radio.label(_serviceName, snapshot.ServiceLabelCharset);
+  const char* label = snapshot.ServiceStart ? radio.label(snapshot.service[snapshot.ServiceIndex].Label, snapshot.ServiceLabelCharset) : name;
+  const char* ps = snapshot.ServiceStart ? radio.label(snapshot.PStext, snapshot.ServiceLabelCharset) : name;
+
+  if (PSold != label || displayreset) {
+    if (tunemode != TUNE_MEM || (tunemode == TUNE_MEM && (snapshot.signallock && snapshot.ServiceStart ? ps : name)[0] != '\0')) {
       OneBigLineSprite.pushImage(-44, -185, 320, 240, Background);
       OneBigLineSprite.setTextColor(SecondaryColor, SecondaryColorSmooth, false);
       OneBigLineSprite.setTextDatum(TC_DATUM);
       OneBigLineSprite.setTextColor(SecondaryColor, SecondaryColorSmooth, false);
-      OneBigLineSprite.drawString(String((radio.ServiceStart ? radio.ASCII(radio.PStext, radio.ServiceLabelCharset) : (radio.signallock && tunemode != TUNE_MEM && !tuning && !seek ? (radio.numberofservices > 0 ? myLanguage[language][74] : myLanguage[language][73]) : radio.ASCII(_serviceName, radio.ServiceLabelCharset)))), 130, 4);
+      OneBigLineSprite.drawString(snapshot.ServiceStart ? ps : (snapshot.signallock && tunemode != TUNE_MEM && !tuning && !seek ? (snapshot.numberofservices > 0 ? myLanguage[language][74] : myLanguage[language][73]) : name), 130, 4);
       OneBigLineSprite.pushSprite(44, 185);
     }
-    PSold = (radio.ServiceStart ? radio.ASCII(radio.PStext, radio.ServiceLabelCharset) : radio.ASCII(_serviceName, radio.ServiceLabelCharset));
+    PSold = ps;
   }
 }
 
 void ShowEN(void) {
   if (tuning) {
-    strncpy(radio.EnsembleLabel, myLanguage[language][75], sizeof(radio.EnsembleLabel));
-    radio.EnsembleLabel[sizeof(radio.EnsembleLabel) - 1] = '\0';
-  } else if (!radio.signallock) {
-    strncpy(radio.EnsembleLabel, myLanguage[language][76], sizeof(radio.EnsembleLabel));
-    radio.EnsembleLabel[sizeof(radio.EnsembleLabel) - 1] = '\0';
+    strncpy(snapshot.EnsembleLabel, myLanguage[language][75], sizeof(snapshot.EnsembleLabel));
+    snapshot.EnsembleLabel[sizeof(snapshot.EnsembleLabel) - 1] = '\0';
+  } else if (!snapshot.signallock) {
+    strncpy(snapshot.EnsembleLabel, myLanguage[language][76], sizeof(snapshot.EnsembleLabel));
+    snapshot.EnsembleLabel[sizeof(snapshot.EnsembleLabel) - 1] = '\0';
   }
 
-  if (EnsembleNameOld != radio.ASCII(radio.EnsembleLabel, radio.EnsembleLabelCharset) || displayreset) {
+  const char* ensemble = radio.label(snapshot.EnsembleLabel, snapshot.EnsembleLabelCharset);
+  if (EnsembleNameOld != ensemble || displayreset) {
     tft.fillRect(167, 162, 145, 16, BackgroundColor4);
-    if (tuning || !radio.signallock) {
+    if (tuning || !snapshot.signallock) {
       if (tuning) {
         tftPrint(0, myLanguage[language][75], 238, 162, SecondaryColor, SecondaryColorSmooth, 16);
-      } else if (!radio.signallock) {
+      } else if (!snapshot.signallock) {
         tftPrint(0, myLanguage[language][76], 238, 162, SecondaryColor, SecondaryColorSmooth, 16);
       }
     } else {
-      tftPrint(0, radio.ASCII(radio.EnsembleLabel, radio.EnsembleLabelCharset), 238, 162, SecondaryColor, SecondaryColorSmooth, 16);
+      tftPrint(0, ensemble, 238, 162, SecondaryColor, SecondaryColorSmooth, 16);
     }
-    EnsembleNameOld = radio.ASCII(radio.EnsembleLabel, radio.EnsembleLabelCharset);
+    EnsembleNameOld = ensemble;
 
   }
-  if (!radio.signallock || tuning) radio.EnsembleLabel[0] = '\0';
+  if (!snapshot.signallock || tuning) snapshot.EnsembleLabel[0] = '\0';
 }
 
 void ShowProtectionlevel(void) {
-  if (!radio.ServiceStart) radio.protectionlevel = 0;
-  if (String(ProtectionText[radio.protectionlevel]) != PLold || displayreset) {
+  if (!snapshot.ServiceStart) snapshot.protectionlevel = 0;
+  if (String(ProtectionText[snapshot.protectionlevel]) != PLold || displayreset) {
     MediumSprite.pushImage(-9, -90, 320, 240, Background);
     MediumSprite.setTextDatum(TC_DATUM);
     MediumSprite.setTextColor(PrimaryColor, PrimaryColorSmooth, false);
-    MediumSprite.drawString(String(ProtectionText[radio.protectionlevel]), 30, 0);
+    MediumSprite.drawString(String(ProtectionText[snapshot.protectionlevel]), 30, 0);
     MediumSprite.pushSprite(9, 90);
-    PLold = String(ProtectionText[radio.protectionlevel]);
+    PLold = String(ProtectionText[snapshot.protectionlevel]);
   }
 }
 
 void ShowAudioMode(void) {
-  if (!radio.ServiceStart) radio.servicetype = 9;
-  if (servicetypeold != radio.servicetype || displayreset) {
+  if (!snapshot.ServiceStart) snapshot.servicetype = 9;
+  if (servicetypeold != snapshot.servicetype || displayreset) {
     tftPrint(-1, ServiceTypeText[4], 70, 33, GreyoutColor, BackgroundColor, 16);
-    if (radio.servicetype == 4 || radio.servicetype == 5) tftPrint(-1, ServiceTypeText[radio.servicetype], 70, 33, SecondaryColor, SecondaryColorSmooth, 16);
-    servicetypeold = radio.servicetype;
+    if (snapshot.servicetype == 4 || snapshot.servicetype == 5) tftPrint(-1, ServiceTypeText[snapshot.servicetype], 70, 33, SecondaryColor, SecondaryColorSmooth, 16);
+    servicetypeold = snapshot.servicetype;
   }
 
-  if (!radio.ServiceStart) radio.audiomode = 4;
-  if (audiomodeold != radio.audiomode || displayreset) {
-    switch (radio.audiomode) {
+  if (!snapshot.ServiceStart) snapshot.audiomode = 4;
+  if (audiomodeold != snapshot.audiomode || displayreset) {
+    switch (snapshot.audiomode) {
       case 0: tft.pushImage(10, 4, 28, 19, mono); break;
       case 1: tft.pushImage(10, 4, 28, 19, mono); break;
       case 2:
       case 3: tft.pushImage(10, 4, 28, 19, stereoon); break;
       case 4: tft.pushImage(10, 4, 28, 19, stereooff); break;
     }
-    audiomodeold = radio.audiomode;
+    audiomodeold = snapshot.audiomode;
   }
 }
 
 void ShowECC(void) {
-  if (eccold != radio.ecc || displayreset) {
+  if (eccold != snapshot.ecc || displayreset) {
     String ITU = "";
-    switch (radio.serviceHasOwnEcc ? radio.SID[0] : radio.EID[0]) {
+    switch (snapshot.serviceHasOwnEcc ? snapshot.SID[0] : snapshot.EID[0]) {
       case '1':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, de); ITU = "D"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, gr); ITU = "GRC"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, ma); ITU = "MRC"; break;
@@ -833,7 +868,7 @@ void ShowECC(void) {
         break;
 
       case '2':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, dz); ITU = "ALG"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, cy); ITU = "CYP"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, cz); ITU = "CZE"; break;
@@ -844,7 +879,7 @@ void ShowECC(void) {
         break;
 
       case '3':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, ad); ITU = "AND"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, sm); ITU = "SM"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, pl); ITU = "POL"; break;
@@ -855,7 +890,7 @@ void ShowECC(void) {
         break;
 
       case '4':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, il); ITU = "ISR"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, ch); ITU = "SUI"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, va); ITU = "CVA"; break;
@@ -864,7 +899,7 @@ void ShowECC(void) {
         break;
 
       case '5':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, it); ITU = "I"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, jo); ITU = "JOR"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, sk); ITU = "SVK"; break;
@@ -874,7 +909,7 @@ void ShowECC(void) {
         break;
 
       case '6':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, be); ITU = "BEL"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, fi); ITU = "FNL"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, sy); ITU = "SYR"; break;
@@ -884,7 +919,7 @@ void ShowECC(void) {
         break;
 
       case '7':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, ru); ITU = "RUS"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, lu); ITU = "LUX"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, tn); ITU = "TUN"; break;
@@ -894,7 +929,7 @@ void ShowECC(void) {
         break;
 
       case '8':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, ra); ITU = "AZR"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, bg); ITU = "BUL"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, m1); ITU = "MDR"; break;
@@ -905,7 +940,7 @@ void ShowECC(void) {
         break;
 
       case '9':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, al); ITU = "ALB"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, dk); ITU = "DNK"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, li); ITU = "LIE"; break;
@@ -916,7 +951,7 @@ void ShowECC(void) {
         break;
 
       case 'A':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, at); ITU = "AUT"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, gi); ITU = "GIB"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, is); ITU = "ISL"; break;
@@ -927,7 +962,7 @@ void ShowECC(void) {
         break;
 
       case 'B':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, hu); ITU = "HNG"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, iq); ITU = "IRQ"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, mc); ITU = "MCO"; break;
@@ -938,7 +973,7 @@ void ShowECC(void) {
         break;
 
       case 'C':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, mt); ITU = "MLT"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, gb); ITU = "G"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, lt); ITU = "LTU"; break;
@@ -949,7 +984,7 @@ void ShowECC(void) {
         break;
 
       case 'D':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, de); ITU = "D"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, ly); ITU = "LBY"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, rs); ITU = "SRB"; break;
@@ -959,7 +994,7 @@ void ShowECC(void) {
         break;
 
       case 'E':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, c1); ITU = "CNR"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, ro); ITU = "ROU"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, es); ITU = "E"; break;
@@ -970,7 +1005,7 @@ void ShowECC(void) {
         break;
 
       case 'F':
-        switch (radio.ecc) {
+        switch (snapshot.ecc) {
           case 0xe0: tft.pushImage(80, 110, 36, 23, eg); ITU = "EGY"; break;
           case 0xe1: tft.pushImage(80, 110, 36, 23, fr); ITU = "F"; break;
           case 0xe2: tft.pushImage(80, 110, 36, 23, no); ITU = "NOR"; break;
@@ -982,7 +1017,7 @@ void ShowECC(void) {
       default: tft.pushImage(80, 110, 36, 23, unknown); ITU = ""; break;
     }
     tftReplace(0, ITUold, ITU, 97, 140, SecondaryColor, SecondaryColorSmooth, BackgroundColor3, 16);
-    eccold = radio.ecc;
+    eccold = snapshot.ecc;
     ITUold = ITU;
   }
 }
@@ -1032,7 +1067,7 @@ void ShowVolume(void) {
 void ShowSignalLevel(void) {
   if (millis() >= rssiTimer + 100) {
     rssiTimer = millis();
-    CNR = radio.cnr;
+    CNR = snapshot.cnr;
   }
 
   SAvg = (((SAvg * 9) + 5) / 10) + SignalLevel;
@@ -1077,7 +1112,7 @@ void ShowSignalLevel(void) {
     }
 
     if (CNRold != CNR || displayreset) {
-      if (radio.signallock) {
+      if (snapshot.signallock) {
         tftPrint(1, String("--"), 289, 109, BackgroundColor, BackgroundColor3, 16);
         tftReplace(1, String(CNRold), String(CNR), 289, 109, PrimaryColor, PrimaryColorSmooth, BackgroundColor3, 16);
       } else {
@@ -1086,12 +1121,12 @@ void ShowSignalLevel(void) {
       CNRold = CNR;
     }
 
-    if (ficold != radio.fic || displayreset) {
-      byte quality = map(radio.fic, 0, 100, 139, 0);
+    if (ficold != snapshot.fic || displayreset) {
+      byte quality = map(snapshot.fic, 0, 100, 139, 0);
       for (byte x = 0; x < 10; x++) tft.pushImage (135, 91 + x, 139, 1, QualLine);
       tft.fillRect(274 - quality, 91, quality, 10, BackgroundColor3);
-      tftReplace(1, String(ficold) + "%", String(radio.fic) + "%", 315, 90, PrimaryColor, PrimaryColorSmooth, BackgroundColor3, 16);
-      ficold = radio.fic;
+      tftReplace(1, String(ficold) + "%", String(snapshot.fic) + "%", 315, 90, PrimaryColor, PrimaryColorSmooth, BackgroundColor3, 16);
+      ficold = snapshot.fic;
     }
 
 
@@ -1110,19 +1145,19 @@ void ShowSignalLevel(void) {
 }
 
 void ShowBitrate(void) {
-  if (tuning) radio.bitrate = 0;
-  if (radio.bitrate != BitrateOld || displayreset) {
+  if (tuning) snapshot.bitrate = 0;
+  if (snapshot.bitrate != BitrateOld || displayreset) {
     MediumSprite.pushImage(-9, -140, 320, 240, Background);
     MediumSprite.setTextDatum(TC_DATUM);
     MediumSprite.setTextColor(PrimaryColor, PrimaryColorSmooth, false);
-    MediumSprite.drawString((radio.bitrate != 0 && radio.ServiceStart && !tuning ? String (radio.bitrate, DEC) + " kbit/s" : ""), 30, 0);
+    MediumSprite.drawString((snapshot.bitrate != 0 && snapshot.ServiceStart && !tuning ? String (snapshot.bitrate, DEC) + " kbit/s" : ""), 30, 0);
     MediumSprite.pushSprite(9, 140);
-    BitrateOld = radio.bitrate;
+    BitrateOld = snapshot.bitrate;
   }
 }
 
 void ShowClock(void) {
-  if (radio.signallock) setTime(radio.Hours, radio.Minutes, radio.Seconds, radio.Days, radio.Months, radio.Year);
+  if (snapshot.signallock) setTime(snapshot.Hours, snapshot.Minutes, snapshot.Seconds, snapshot.Days, snapshot.Months, snapshot.Year);
   String clockstring = (hour() < 10 ? "0" : "") + String(hour()) + ":" + (minute() < 10 ? "0" : "") + String(minute());
   String datestring = (day() < 10 ? "0" : "") + String(day()) + "-" + (month() < 10 ? "0" : "") + String(month()) + "-" + String(year());
   if (clockstringOld != clockstring || displayreset) {
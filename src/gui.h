@@ -5,6 +5,8 @@
 #include <TFT_eSPI.h>
 #include <TimeLib.h>
 #include "si4684.h"
+#include "radiotask.h"
+#include "epg.h"
 #include "TPA6130A2.h"
 #include "language.h"
 #include "constants.h"
@@ -103,6 +105,7 @@ extern TFT_eSprite MediumSprite;
 extern TFT_eSprite ModeSprite;
 extern TFT_eSprite ShortSprite;
 extern DAB radio;
+extern RadioSnapshot snapshot;
 extern TPA6130A2 Headphones;
 
 void BuildChannelList(void);
@@ -133,6 +136,9 @@ void ShowSlideShowIcon(void);
 void ShowTuneMode(void);
 void ShowRSSI(void);
 void ShowOneLine(byte position, byte item, bool selected);
+byte ChannelListPage(byte index);
+byte ChannelListTop(byte index);
+const char* EPGText(void);
 
 extern void ShowTuneMode(void);
 extern void tftPrint(int8_t offset, const String & text, int16_t x, int16_t y, int color, int smoothcolor, uint8_t fontsize);
@@ -0,0 +1,178 @@
+#include "muxdb.h"
+#include <TimeLib.h>
+
+extern DAB radio;
+
+MuxHeader muxIndex[MUXDB_CHANNELS];
+
+static String muxdbFilename(uint8_t channel);
+static bool muxdbValid(const MuxHeader& header, uint8_t channel);
+
+// Read every header into RAM, the service lists stay on flash until their channel is tuned
+void muxdbBegin(void) {
+  for (uint8_t channel = 0; channel < MUXDB_CHANNELS; channel++) {
+    memset(&muxIndex[channel], 0, sizeof(MuxHeader));
+    File file = LittleFS.open(muxdbFilename(channel), "r");
+    if (!file) continue;
+
+    MuxHeader header;
+    if (file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && muxdbValid(header, channel)) muxIndex[channel] = header;
+    file.close();
+  }
+}
+
+// Clean slate on boot for everything but the multiplex database and the EPG schedules
+void muxdbClean(void) {
+  bool removed = true;
+  while (removed) {
+    removed = false;
+    File root = LittleFS.open("/");
+    File file = root.openNextFile();
+    while (file) {
+      String filename = file.name();
+      if (!((filename.startsWith("mux_") || filename.startsWith("epg_")) && filename.endsWith(".db")) && !("/" + filename).equals(SI468X_EMU_FILE)) {
+        file.close();
+        root.close();
+        LittleFS.remove("/" + filename);
+        removed = true;
+        break;
+      }
+      file = root.openNextFile();
+    }
+    if (!removed) root.close();
+  }
+}
+
+const MuxHeader* muxdbEnsemble(uint8_t channel) {
+  if (channel >= MUXDB_CHANNELS || muxIndex[channel].magic != MUXDB_MAGIC) return NULL;
+  return &muxIndex[channel];
+}
+
+// Fill the service list of a fresh tune from the database, the live list replaces it once the chip has one
+bool muxdbRestore(uint8_t channel) {
+  if (muxdbEnsemble(channel) == NULL) return false;
+
+  File file = LittleFS.open(muxdbFilename(channel), "r");
+  if (!file) return false;
+
+  MuxHeader header;
+  bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && muxdbValid(header, channel);
+
+  for (uint8_t x = 0; ok && x < header.services; x++) {
+    MuxService entry;
+    ok = file.read((uint8_t*)&entry, sizeof(entry)) == sizeof(entry);
+    radio.service[x].ServiceID = entry.ServiceID;
+    radio.service[x].CompID = entry.CompID;
+    radio.service[x].ServiceType = entry.ServiceType;
+    memcpy(radio.service[x].Label, entry.Label, sizeof(entry.Label));
+    radio.service[x].Label[16] = '\0';
+  }
+
+  for (uint8_t x = 0; ok && x < header.components; x++) {
+    MuxComponent entry;
+    ok = file.read((uint8_t*)&entry, sizeof(entry)) == sizeof(entry);
+    radio.component[x].ServiceID = entry.ServiceID;
+    radio.component[x].CompID = entry.CompID;
+    radio.component[x].ServiceType = entry.ServiceType;
+  }
+  file.close();
+
+  if (!ok) {
+    radio.clearData();
+    return false;
+  }
+
+  radio.numberofservices = header.services;
+  radio.numberofcomponents = header.components;
+  memcpy(radio.EID, header.EID, sizeof(radio.EID));
+  radio.EID[4] = '\0';
+  memcpy(radio.EnsembleLabel, header.Label, sizeof(radio.EnsembleLabel));
+  radio.EnsembleLabel[16] = '\0';
+  radio.EnsembleLabelCharset = header.LabelCharset;
+  radio.setCachedList(header.ListVersion);
+  return true;
+}
+
+bool muxdbHasService(uint8_t channel, uint32_t ServiceID) {
+  const MuxHeader* header = muxdbEnsemble(channel);
+  if (header == NULL) return false;
+
+  File file = LittleFS.open(muxdbFilename(channel), "r");
+  if (!file) return false;
+  file.seek(sizeof(MuxHeader));
+
+  bool found = false;
+  for (uint8_t x = 0; x < header->services && !found; x++) {
+    MuxService entry;
+    if (file.read((uint8_t*)&entry, sizeof(entry)) != sizeof(entry)) break;
+    found = (entry.ServiceID == ServiceID);
+  }
+  file.close();
+  return found;
+}
+
+// Write the tuned ensemble once its live list and every component type are known, and only when it changed
+void muxdbStore(uint8_t channel) {
+  if (channel >= MUXDB_CHANNELS || !radio.signallock || radio.ServiceListCached || radio.EnsembleCached) return;
+  if (radio.numberofservices == 0 || radio.EID[0] == '\0' || radio.EnsembleLabel[0] == '\0') return;
+
+  MuxHeader* index = &muxIndex[channel];
+  bool changed = index->magic != MUXDB_MAGIC || index->ListVersion != radio.ServiceListVersion || index->services != radio.numberofservices ||
+                 strcmp(index->EID, radio.EID) != 0 || memcmp(index->Label, radio.EnsembleLabel, sizeof(index->Label)) != 0;
+  bool stale = now() > index->LastSeen + MUXDB_REFRESH;
+  if ((!changed && !stale) || !radio.getComponentsKnown()) return;
+
+  MuxHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = MUXDB_MAGIC;
+  header.version = MUXDB_VERSION;
+  header.channel = channel;
+  header.ListVersion = radio.ServiceListVersion;
+  header.LastSeen = now();
+  memcpy(header.EID, radio.EID, sizeof(header.EID));
+  memcpy(header.Label, radio.EnsembleLabel, sizeof(header.Label));
+  header.LabelCharset = radio.EnsembleLabelCharset;
+  header.services = radio.numberofservices;
+  header.components = radio.numberofcomponents;
+
+  // Written aside and renamed so a power cut never leaves half a record behind
+  File file = LittleFS.open("/mux.tmp", "w");
+  if (!file) return;
+
+  bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+
+  for (uint8_t x = 0; ok && x < header.services; x++) {
+    MuxService entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.ServiceID = radio.service[x].ServiceID;
+    entry.CompID = radio.service[x].CompID;
+    entry.ServiceType = radio.service[x].ServiceType;
+    memcpy(entry.Label, radio.service[x].Label, sizeof(entry.Label));
+    ok = file.write((const uint8_t*)&entry, sizeof(entry)) == sizeof(entry);
+  }
+
+  for (uint8_t x = 0; ok && x < header.components; x++) {
+    MuxComponent entry;
+    entry.ServiceID = radio.component[x].ServiceID;
+    entry.CompID = radio.component[x].CompID;
+    entry.ServiceType = radio.component[x].ServiceType;
+    ok = file.write((const uint8_t*)&entry, sizeof(entry)) == sizeof(entry);
+  }
+  file.close();
+
+  if (!ok) {
+    LittleFS.remove("/mux.tmp");
+    return;
+  }
+
+  if (LittleFS.rename("/mux.tmp", muxdbFilename(channel))) *index = header;
+}
+
+static String muxdbFilename(uint8_t channel) {
+  return "/mux_" + String(channel) + ".db";
+}
+
+static bool muxdbValid(const MuxHeader& header, uint8_t channel) {
+  return header.magic == MUXDB_MAGIC && header.version == MUXDB_VERSION && header.channel == channel &&
+         header.services <= MAX_SERVICES && header.components <= MAX_COMPONENTS;
+}
@@ -0,0 +1,48 @@
+#ifndef muxdb_h
+#define muxdb_h
+
+#include "Arduino.h"
+#include <FS.h>
+#include <LittleFS.h>
+#include "si4684.h"
+
+#define MUXDB_MAGIC     0x4D555844  // "MUXD"
+#define MUXDB_VERSION   1           // Bump when any record below changes, old files are then ignored
+#define MUXDB_CHANNELS  (sizeof(DABfrequencyTable_DAB) / sizeof(DABFrequencyLabel_DAB))
+#define MUXDB_REFRESH   86400       // s before an unchanged ensemble is written again to refresh LastSeen
+
+// One /mux_<channel>.db file per channel: the header, then its services, then its components
+typedef struct __attribute__((packed)) _MuxHeader {
+  uint32_t  magic;
+  uint8_t   version;
+  uint8_t   channel;
+  uint16_t  ListVersion;
+  uint32_t  LastSeen;         // TimeLib now() when the file was written
+  char      EID[5];
+  char      Label[17];
+  uint8_t   LabelCharset;
+  uint8_t   services;
+  uint8_t   components;
+} MuxHeader;
+
+typedef struct __attribute__((packed)) _MuxService {
+  uint32_t  ServiceID;
+  uint32_t  CompID;
+  uint8_t   ServiceType;
+  char      Label[17];
+} MuxService;
+
+typedef struct __attribute__((packed)) _MuxComponent {
+  uint32_t  ServiceID;
+  uint32_t  CompID;
+  uint8_t   ServiceType;
+} MuxComponent;
+
+void muxdbBegin(void);
+void muxdbClean(void);
+const MuxHeader* muxdbEnsemble(uint8_t channel);
+bool muxdbRestore(uint8_t channel);
+bool muxdbHasService(uint8_t channel, uint32_t ServiceID);
+void muxdbStore(uint8_t channel);
+
+#endif
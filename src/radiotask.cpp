@@ -0,0 +1,353 @@
+#include <atomic>
+#include "radiotask.h"
+#include "muxdb.h"
+#include "si468xbus.h"
+
+extern DAB radio;
+extern unsigned long recoverytime;
+
+SPSCQueue<RadioMessage, RADIO_QUEUE_SIZE> radioCommands;
+SPSCQueue<RadioMessage, RADIO_QUEUE_SIZE> radioEvents;
+SPSCQueue<TelemetrySample, TELEMETRY_SAMPLES> radioSamples;
+uint16_t samplesDropped;
+uint16_t samplePeriod;
+unsigned long sampleMillis;
+RadioSnapshot snapshots[2];
+uint32_t snapshotSequence;
+uint32_t commandsDone;
+uint32_t commandsPosted;
+uint32_t selectionPosted;
+uint32_t selectionServiceID;
+bool selectionStart;
+SemaphoreHandle_t radioMutex;
+TaskHandle_t radioHandle;
+uint8_t tunedFreq;
+uint32_t findServiceID;
+bool findService;
+ScanCallback sweepReport;
+uint32_t followServiceID;
+unsigned long followStarted;
+Si468xRecorder recorder;
+char radioChip[16];
+
+static void radioTask(void* parameter);
+static void radioCommand(const RadioMessage& command);
+static void radioPublish(void);
+static void radioSample(void);
+static void radioScanReport(const ScanResult& result);
+static void radioSweepReport(const ScanResult& result);
+static void radioFollowReport(const ScanResult& result);
+
+void radioStart(uint8_t freq) {
+  tunedFreq = freq;
+  snprintf(radioChip, sizeof(radioChip), "%s/%s", radio.getChipID(), radio.getFirmwareVersion());
+  radioMutex = xSemaphoreCreateRecursiveMutex();
+  radioPublish();
+  xTaskCreatePinnedToCore(radioTask, "radio", RADIO_STACK, NULL, RADIO_PRIORITY, &radioHandle, RADIO_CORE);
+}
+
+bool radioPost(uint8_t type, uint32_t value) {
+  RadioMessage command = {type, value};
+  if (!radioCommands.push(command)) return false;
+  commandsPosted++;
+
+  // Remembered so radioSnapshot() shows the selection before the radio task gets to it
+  if (type == RADIO_SERVICE || type == RADIO_CLEAR) {
+    selectionPosted = commandsPosted;
+    selectionServiceID = (type == RADIO_SERVICE) ? value : 0;
+    selectionStart = (type == RADIO_SERVICE);
+  }
+  return true;
+}
+
+// The callback runs on the radio task with the lock held, once per channel and once more at the end
+bool radioSweep(ScanCallback callback) {
+  sweepReport = callback;
+  return radioPost(RADIO_SWEEP);
+}
+
+bool radioEvent(RadioMessage& event) {
+  return radioEvents.pop(event);
+}
+
+bool radioTelemetry(TelemetrySample& sample) {
+  return radioSamples.pop(sample);
+}
+
+// Samples the full ring refused since the last call
+uint16_t radioTelemetryDropped(void) {
+  return __atomic_exchange_n(&samplesDropped, 0, __ATOMIC_RELAXED);
+}
+
+void radioSnapshot(RadioSnapshot& snapshot) {
+  // The radio task only writes the buffer that is not published, retry if it flipped during the copy
+  uint32_t sequence;
+  do {
+    sequence = __atomic_load_n(&snapshotSequence, __ATOMIC_ACQUIRE);
+    const RadioSnapshot* published = &snapshots[sequence & 1];
+    uint8_t services = min(published->numberofservices, (uint8_t)MAX_SERVICES);
+    memcpy(&snapshot, published, offsetof(RadioSnapshot, service) + services * sizeof(DABService));
+    std::atomic_thread_fence(std::memory_order_acquire);  // The copy is done before the sequence is read again
+  } while (sequence != __atomic_load_n(&snapshotSequence, __ATOMIC_ACQUIRE));
+
+  if (snapshot.numberofservices > MAX_SERVICES) snapshot.numberofservices = MAX_SERVICES;
+  if ((int32_t)(selectionPosted - snapshot.CommandsDone) > 0) {
+    if (selectionStart) {
+      // Shown only while the service is still in the list the radio task will look it up in
+      for (uint8_t x = 0; x < snapshot.numberofservices; x++) {
+        if (snapshot.service[x].ServiceID != selectionServiceID) continue;
+        snapshot.ServiceIndex = x;
+        snapshot.ServiceStart = true;
+        break;
+      }
+    } else {
+      snapshot.ServiceIndex = 0;
+      snapshot.ServiceStart = false;
+    }
+  }
+}
+
+// Only for putting the chip on standby before deep sleep, everything else goes through radioPost()
+void radioLock(void) {
+  if (radioMutex != NULL) xSemaphoreTakeRecursive(radioMutex, portMAX_DELAY);
+}
+
+void radioUnlock(void) {
+  if (radioMutex != NULL) xSemaphoreGiveRecursive(radioMutex);
+}
+
+static void radioTask(void* parameter) {
+  unsigned long published = millis();
+  RadioMessage command;
+
+  for (;;) {
+    radioLock();
+    while (radioCommands.pop(command)) {
+      radioCommand(command);
+      commandsDone++;
+    }
+
+    if (scanActive()) scanStep(); else radio.Update();
+
+    if (radio.crashed) {
+      scanStop();
+      unsigned long start = millis();
+      radio.begin(SI4684_SS, SI4684_INTB);
+      radio.setFreq(tunedFreq);
+      muxdbRestore(tunedFreq);
+      recoverytime = millis() - start;
+      RadioMessage event = {RADIO_RECOVERED, 0};
+      radioEvents.push(event);
+    }
+
+    if (findService && radio.signallock) {
+      int16_t x = radio.findService(findServiceID);
+      if (x >= 0) {
+        radio.setService(x);
+        radio.ServiceStart = true;
+        findService = false;
+        if (followStarted != 0) {
+          FollowTime = millis() - followStarted;
+          followStarted = 0;
+        }
+        RadioMessage event = {RADIO_SERVICE_STARTED, (uint32_t)x};
+        radioEvents.push(event);
+      }
+    }
+
+    if (!scanActive()) {
+      muxdbStore(tunedFreq);
+
+      uint8_t candidates[FOLLOW_CANDIDATES];
+      uint8_t count = followCheck(tunedFreq, candidates);
+      if (count > 0) {
+        followServiceID = radio.service[radio.ServiceIndex].ServiceID;
+        followStarted = millis();
+        scanStartList(candidates, count, tunedFreq, radioFollowReport);
+      }
+    }
+
+    if (samplePeriod != 0 && !scanActive()) radioSample();
+
+    if (millis() - published >= RADIO_SNAPSHOT_PERIOD) {
+      radioPublish();
+      published = millis();
+    }
+    radioUnlock();
+    vTaskDelay(1);
+  }
+}
+
+static void radioCommand(const RadioMessage& command) {
+  switch (command.type) {
+    case RADIO_TUNE: {
+        scanStop();
+        followReset();
+        tunedFreq = command.value;
+        radio.setFreq(tunedFreq);
+        muxdbRestore(tunedFreq);
+        radio.Update();
+        RadioMessage event = {RADIO_TUNED, radio.signallock};
+        radioEvents.push(event);
+      }
+      break;
+
+    case RADIO_SERVICE: {
+        // By ServiceID, the list may have changed since the UI picked from its snapshot
+        int16_t index = radio.findService(command.value);
+        if (index >= 0) {
+          followReset();
+          radio.setService(index);
+          radio.ServiceStart = true;
+        }
+      }
+      break;
+
+    case RADIO_FIND_SERVICE:
+      findServiceID = command.value;
+      findService = true;
+      break;
+
+    case RADIO_FIND_CANCEL:
+      findService = false;
+      break;
+
+    case RADIO_SEEK:
+      scanStop();
+      scanStart((command.value & 0x100) ? SCAN_SEEK_DOWN : SCAN_SEEK_UP, command.value & 0xFF, radioScanReport);
+      break;
+
+    case RADIO_SWEEP:
+      scanStop();
+      scanStart(SCAN_SWEEP, tunedFreq, radioSweepReport);
+      break;
+
+    case RADIO_SCAN_CANCEL:
+      scanStop();
+      break;
+
+    case RADIO_FOLLOW:
+      followEnable(command.value);
+      break;
+
+    case RADIO_ANNOUNCE:
+      radio.AnnouncementMask = command.value;
+      if ((radio.AnnouncementType & radio.AnnouncementMask) == 0) radio.endAnnouncement();
+      radio.FICDecode = followEnabled() || radio.AnnouncementMask != 0;
+      break;
+
+    case RADIO_FIC:
+      radio.FIGTypeMask = command.value;
+      radio.FICStream = (command.value != 0);
+      radio.FIGForwarded = 0;
+      radio.FIGDuplicates = 0;
+      break;
+
+    case RADIO_FIC_EXT:
+      radio.FIG0ExtMask = command.value;
+      break;
+
+    case RADIO_TELEMETRY:
+      samplePeriod = command.value;
+      sampleMillis = millis();
+      break;
+
+    case RADIO_TRACE:
+      if (command.value == 1 && radio.getBus() != &recorder && recorder.start(radio.getBus(), SI468X_TRACE_FILE)) {
+        radio.setBus(&recorder);
+      } else if (command.value == 0 && radio.getBus() == &recorder) {
+        recorder.stop();
+        radio.setBus(recorder.target());
+      }
+      break;
+
+    case RADIO_CLEAR:
+      radio.ServiceIndex = 0;
+      radio.ServiceStart = false;
+      radio.clearData();
+      break;
+  }
+}
+
+static void radioScanReport(const ScanResult& result) {
+  if (result.last) {
+    tunedFreq = result.channel;
+    RadioMessage event = {RADIO_SCAN_DONE, (uint32_t)(result.channel | (radio.signallock ? 0x100 : 0))};
+    radioEvents.push(event);
+  } else {
+    RadioMessage event = {RADIO_SCAN_PROGRESS, result.channel};
+    radioEvents.push(event);
+  }
+}
+
+static void radioSweepReport(const ScanResult& result) {
+  radioScanReport(result);
+  if (sweepReport != NULL) sweepReport(result);
+}
+
+// Either on an alternative that locked or back home, the service is started again by ServiceID
+static void radioFollowReport(const ScanResult& result) {
+  if (!result.last) return;
+  if (result.channel != tunedFreq) FollowSwitches++;
+  tunedFreq = result.channel;
+  if (radio.numberofservices == 0) muxdbRestore(tunedFreq);
+  findServiceID = followServiceID;
+  findService = true;
+  RadioMessage event = {RADIO_FOLLOWED, result.channel};
+  radioEvents.push(event);
+}
+
+static void radioSample(void) {
+  if (millis() - sampleMillis < samplePeriod) return;
+  sampleMillis += samplePeriod;
+  if (millis() - sampleMillis >= samplePeriod) sampleMillis = millis();  // Fell behind, don't burst to catch up
+
+  radio.getSignalStatus();
+  TelemetrySample sample = {(uint32_t)millis(), (int16_t)radio.getRSSI(), radio.cnr, radio.fic};
+  if (!radioSamples.push(sample)) __atomic_add_fetch(&samplesDropped, 1, __ATOMIC_RELAXED);
+}
+
+static void radioPublish(void) {
+  RadioSnapshot* snapshot = &snapshots[(snapshotSequence + 1) & 1];
+
+  snapshot->CommandsDone = commandsDone;
+  snapshot->ServiceStart = radio.ServiceStart;
+  snapshot->ServiceIndex = radio.ServiceIndex;
+  snapshot->numberofservices = radio.numberofservices;
+  memcpy(snapshot->service, radio.service, radio.numberofservices * sizeof(DABService));
+  snapshot->signallock = radio.signallock;
+  snapshot->serviceHasOwnEcc = radio.serviceHasOwnEcc;
+  snapshot->rssi = radio.rssi;
+  snapshot->cnr = radio.cnr;
+  snapshot->fic = radio.fic;
+  snapshot->bitrate = radio.bitrate;
+  snapshot->samplerate = radio.samplerate;
+  snapshot->ServiceListVersion = radio.ServiceListVersion;
+  snapshot->ComponentGeneration = radio.ComponentGeneration;
+  snapshot->ecc = radio.ecc;
+  snapshot->audiomode = radio.audiomode;
+  snapshot->pty = radio.pty;
+  snapshot->protectionlevel = radio.protectionlevel;
+  snapshot->servicetype = radio.servicetype;
+  snapshot->EnsembleLabelCharset = radio.EnsembleLabelCharset;
+  snapshot->ServiceLabelCharset = radio.ServiceLabelCharset;
+  snapshot->Year = radio.Year;
+  snapshot->Months = radio.Months;
+  snapshot->Days = radio.Days;
+  snapshot->Hours = radio.Hours;
+  snapshot->Minutes = radio.Minutes;
+  snapshot->Seconds = radio.Seconds;
+  memcpy(snapshot->EID, radio.EID, sizeof(snapshot->EID));
+  memcpy(snapshot->SID, radio.SID, sizeof(snapshot->SID));
+  memcpy(snapshot->PStext, radio.PStext, sizeof(snapshot->PStext));
+  memcpy(snapshot->EnsembleLabel, radio.EnsembleLabel, sizeof(snapshot->EnsembleLabel));
+  memcpy(snapshot->ServiceData, radio.ServiceData, sizeof(snapshot->ServiceData));
+  memcpy(snapshot->DLPlus, radio.DLPlus, sizeof(snapshot->DLPlus));
+  snapshot->DLPlusItemRunning = radio.DLPlusItemRunning;
+  snapshot->DLPlusGeneration = radio.DLPlusGeneration;
+  snapshot->Tracing = (radio.getBus() == &recorder);
+  snapshot->TraceTruncated = recorder.truncated();
+  memcpy(snapshot->Chip, radioChip, sizeof(snapshot->Chip));
+
+  __atomic_store_n(&snapshotSequence, snapshotSequence + 1, __ATOMIC_RELEASE);
+}
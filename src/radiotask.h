@@ -0,0 +1,132 @@
+#ifndef radiotask_h
+#define radiotask_h
+
+#include "Arduino.h"
+#include "si4684.h"
+#include "constants.h"
+#include "scanner.h"
+#include "following.h"
+
+#define RADIO_CORE            0     // The UI and Arduino loop() run on core 1
+#define RADIO_STACK           8192
+#define RADIO_PRIORITY        2
+#define RADIO_QUEUE_SIZE      16
+#define RADIO_SNAPSHOT_PERIOD 20    // ms between published snapshots
+#define TELEMETRY_SAMPLES     64    // Ring buffer size, must hold a few frames worth of samples
+
+// Commands, UI to radio task
+#define RADIO_TUNE            1     // value: channel index
+#define RADIO_SERVICE         2     // value: ServiceID, looked up in radio.service[] by the radio task
+#define RADIO_FIND_SERVICE    3     // value: ServiceID, started as soon as it shows up in the list
+#define RADIO_FIND_CANCEL     4
+#define RADIO_CLEAR           5
+#define RADIO_SEEK            6     // value: start channel, bit 8 set to seek down
+#define RADIO_SWEEP           7     // Scan every channel, see radioSweep()
+#define RADIO_SCAN_CANCEL     8
+#define RADIO_FOLLOW          9     // value: 1 to follow the service to other ensembles when reception fails
+#define RADIO_ANNOUNCE        10    // value: ASw flag bits allowed to interrupt the service
+#define RADIO_FIC             11    // value: FIG type mask for getFIG(), 0 stops the stream
+#define RADIO_FIC_EXT         12    // value: FIG 0 extension mask, post before RADIO_FIC
+#define RADIO_TRACE           13    // value: 1 to record the bus to SI468X_TRACE_FILE, 0 to stop
+#define RADIO_TELEMETRY       14    // value: ms between signal samples, 0 stops sampling
+
+// Events, radio task to UI
+#define RADIO_TUNED           1     // value: signal lock after the first update
+#define RADIO_SERVICE_STARTED 2     // value: index in radio.service[]
+#define RADIO_RECOVERED       3
+#define RADIO_SCAN_PROGRESS   4     // value: channel just finished
+#define RADIO_SCAN_DONE       5     // value: channel the tuner stays on, bit 8 set when it has a lock
+#define RADIO_FOLLOWED        6     // value: channel the service was followed to, or back to the old one
+
+typedef struct _RadioMessage {
+  uint8_t   type;
+  uint32_t  value;
+} RadioMessage;
+
+typedef struct _TelemetrySample {
+  uint32_t  time;
+  int16_t   rssi;
+  uint8_t   cnr;
+  uint8_t   fic;
+} TelemetrySample;
+
+// Lock-free ring for exactly one producer task and one consumer task. Neither side ever waits:
+// push() fails when the ring is full and pop() fails when it is empty.
+template <typename T, uint8_t N>
+class SPSCQueue {
+  public:
+    bool push(const T& item) {
+      uint8_t next = (head + 1) % N;
+      if (next == __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) return false;
+      buffer[head] = item;
+      __atomic_store_n(&head, next, __ATOMIC_RELEASE);
+      return true;
+    }
+
+    bool pop(T& item) {
+      if (tail == __atomic_load_n(&head, __ATOMIC_ACQUIRE)) return false;
+      item = buffer[tail];
+      __atomic_store_n(&tail, (uint8_t)((tail + 1) % N), __ATOMIC_RELEASE);
+      return true;
+    }
+
+  private:
+    T buffer[N];
+    uint8_t head = 0;
+    uint8_t tail = 0;
+};
+
+// Copy of the DAB fields the display and serial reports refresh every loop. The UI never touches
+// radio.service[] or the selection itself, it reads them here and changes them with RADIO_SERVICE.
+typedef struct _RadioSnapshot {
+  uint32_t  CommandsDone;       // Commands the radio task has handled, see radioSnapshot()
+  bool      ServiceStart;
+  uint8_t   ServiceIndex;
+  uint8_t   numberofservices;
+  bool      signallock;
+  bool      serviceHasOwnEcc;
+  int16_t   rssi;
+  uint8_t   cnr;
+  uint8_t   fic;
+  uint16_t  bitrate;
+  uint16_t  samplerate;
+  uint16_t  ServiceListVersion;
+  uint16_t  ComponentGeneration;
+  uint16_t  ecc;
+  uint8_t   audiomode;
+  uint8_t   pty;
+  uint8_t   protectionlevel;
+  uint8_t   servicetype;
+  uint8_t   EnsembleLabelCharset;
+  uint8_t   ServiceLabelCharset;
+  uint16_t  Year;
+  uint8_t   Months;
+  uint8_t   Days;
+  uint8_t   Hours;
+  uint8_t   Minutes;
+  uint8_t   Seconds;
+  char      EID[5];
+  char      SID[5];
+  char      PStext[17];
+  char      EnsembleLabel[17];
+  char      ServiceData[128];
+  DLPlusView DLPlus[DLPLUS_FIELDS];
+  bool      DLPlusItemRunning;
+  uint16_t  DLPlusGeneration;
+  bool      Tracing;
+  bool      TraceTruncated;
+  char      Chip[16];           // "SI4684/6.0.5", read once at radioStart()
+  DABService service[MAX_SERVICES];  // Last, only the first numberofservices entries are copied
+} RadioSnapshot;
+
+void radioStart(uint8_t freq);
+bool radioPost(uint8_t type, uint32_t value = 0);
+bool radioSweep(ScanCallback callback);
+bool radioEvent(RadioMessage& event);
+bool radioTelemetry(TelemetrySample& sample);
+uint16_t radioTelemetryDropped(void);
+void radioSnapshot(RadioSnapshot& snapshot);
+void radioLock(void);
+void radioUnlock(void);
+
+#endif
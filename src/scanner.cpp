@@ -0,0 +1,191 @@
+#include "scanner.h"
+
+#define STATE_TUNE    0
+#define STATE_STC     1
+#define STATE_DETECT  2
+#define STATE_LOCK    3
+#define STATE_LIST    4
+
+extern DAB radio;
+
+bool scanning;
+uint8_t scanMode;
+uint8_t scanState;
+uint8_t scanChannel;
+uint8_t scanFirst;
+uint8_t scanFound;
+uint8_t scanList[SCAN_LIST_SIZE];
+uint8_t scanListCount;
+uint8_t scanListIndex;
+unsigned long scanStarted;
+unsigned long scanEntered;  // When scanState last changed, each state's timeout counts from here
+unsigned long scanPolled;
+ScanCallback scanCallback;
+uint16_t scanTimes[MUXDB_CHANNELS];
+uint8_t scanResults[MUXDB_CHANNELS];
+
+static uint8_t scanNext(uint8_t channel);
+static void scanChannelDone(uint8_t result);
+static void scanFinish(uint8_t channel, bool retune);
+
+void scanStart(uint8_t mode, uint8_t channel, ScanCallback callback) {
+  scanMode = mode;
+  scanCallback = callback;
+  scanFirst = channel;
+  scanFound = 0;
+  scanChannel = (mode == SCAN_SWEEP) ? 0 : scanNext(channel);
+  scanState = STATE_TUNE;
+  radio.setScanTiming(true);
+  scanning = true;
+}
+
+void scanStartList(const uint8_t* channels, uint8_t count, uint8_t home, ScanCallback callback) {
+  if (count == 0) return;
+  scanListCount = min(count, (uint8_t)SCAN_LIST_SIZE);
+  memcpy(scanList, channels, scanListCount);
+  scanListIndex = 0;
+  scanStart(SCAN_LIST, home, callback);
+  scanChannel = scanList[0];
+}
+
+// A stopped seek stays where it is, a stopped sweep or list goes back to where it started
+void scanStop(void) {
+  if (!scanning) return;
+  if (scanMode == SCAN_SWEEP || scanMode == SCAN_LIST) scanFinish(scanFirst, true); else scanFinish(scanChannel, false);
+}
+
+bool scanActive(void) {
+  return scanning;
+}
+
+uint16_t scanTime(uint8_t channel) {
+  return (channel < MUXDB_CHANNELS) ? scanTimes[channel] : 0;
+}
+
+uint8_t scanResult(uint8_t channel) {
+  return (channel < MUXDB_CHANNELS) ? scanResults[channel] : SCAN_EMPTY;
+}
+
+// Called from the radio task instead of radio.Update(), never waits on the chip beyond a single command
+void scanStep(void) {
+  if (!scanning) return;
+  unsigned long elapsed = millis() - scanEntered;
+
+  switch (scanState) {
+    case STATE_TUNE:
+      radio.tuneStart(scanChannel);
+      scanStarted = millis();
+      scanEntered = millis();
+      scanPolled = millis();
+      scanState = STATE_STC;
+      break;
+
+    case STATE_STC:
+      if (radio.tuneDone()) {
+        radio.getScanStatus();
+        if (!radio.signalvalid) {
+          scanChannelDone(SCAN_EMPTY);
+        } else {
+          scanStarted = millis();
+          scanEntered = millis();
+          scanState = STATE_DETECT;
+        }
+      } else if (elapsed > SCAN_STC_TIMEOUT) {
+        scanChannelDone(SCAN_EMPTY);
+      }
+      break;
+
+    case STATE_DETECT:
+      if (millis() - scanPolled < SCAN_POLL) break;
+      scanPolled = millis();
+      radio.getScanStatus();
+      if (radio.acquired) {
+        scanEntered = millis();
+        scanState = STATE_LOCK;
+      } else if (radio.fastdetect == 0 && elapsed > SCAN_DETECT_TIMEOUT) {
+        scanChannelDone(SCAN_NO_DAB);
+      } else if (elapsed > SCAN_ACQ_TIMEOUT) {
+        scanChannelDone(SCAN_NO_LOCK);
+      }
+      break;
+
+    case STATE_LOCK:
+      radio.ScanUpdate();
+      if (radio.signallock) {
+        if (scanMode == SCAN_SWEEP) {
+          scanEntered = millis();
+          scanState = STATE_LIST;
+        } else {
+          scanFound++;
+          scanResults[scanChannel] = SCAN_ENSEMBLE;
+          scanTimes[scanChannel] = millis() - scanStarted;
+          scanFinish(scanChannel, false);
+        }
+      } else if (elapsed > SCAN_ACQ_TIMEOUT) {
+        scanChannelDone(SCAN_NO_LOCK);
+      }
+      break;
+
+    case STATE_LIST:
+      radio.ScanUpdate();
+      if (radio.numberofservices > 0 && radio.EID[0] != '\0' && radio.EnsembleLabel[0] != '\0' && radio.getComponentsKnown()) {
+        muxdbStore(scanChannel);
+        scanChannelDone(SCAN_ENSEMBLE);
+      } else if (elapsed > SCAN_LIST_TIMEOUT) {
+        scanChannelDone(SCAN_NO_LIST);
+      }
+      break;
+  }
+}
+
+static uint8_t scanNext(uint8_t channel) {
+  if (scanMode == SCAN_SEEK_DOWN) return (channel == 0) ? MUXDB_CHANNELS - 1 : channel - 1;
+  return (channel + 1) % MUXDB_CHANNELS;
+}
+
+static void scanChannelDone(uint8_t result) {
+  scanResults[scanChannel] = result;
+  scanTimes[scanChannel] = millis() - scanStarted;
+  if (result == SCAN_ENSEMBLE) scanFound++;
+
+  if (scanCallback != NULL) {
+    ScanResult report = {scanChannel, result, scanTimes[scanChannel], scanFound, false};
+    scanCallback(report);
+  }
+
+  // A sweep ends after the last channel, a list after its last entry, a seek when it is back where it started
+  if (scanMode == SCAN_LIST) {
+    if (++scanListIndex >= scanListCount) {
+      scanFinish(scanFirst, true);
+      return;
+    }
+    scanChannel = scanList[scanListIndex];
+  } else if (scanMode == SCAN_SWEEP) {
+    if (scanChannel + 1 >= MUXDB_CHANNELS) {
+      scanFinish(scanFirst, true);
+      return;
+    }
+    scanChannel++;
+  } else {
+    scanChannel = scanNext(scanChannel);
+    if (scanChannel == scanFirst) {
+      scanFinish(scanFirst, true);
+      return;
+    }
+  }
+  scanState = STATE_TUNE;
+}
+
+static void scanFinish(uint8_t channel, bool retune) {
+  scanning = false;
+  radio.setScanTiming(false);
+  if (retune) {
+    radio.setFreq(channel);
+    muxdbRestore(channel);
+  }
+
+  if (scanCallback != NULL) {
+    ScanResult report = {channel, scanResults[channel], scanTimes[channel], scanFound, true};
+    scanCallback(report);
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef scanner_h
+#define scanner_h
+
+#include "Arduino.h"
+#include "si4684.h"
+#include "muxdb.h"
+
+#define SCAN_SEEK_UP        0     // Stop on the first channel that locks
+#define SCAN_SEEK_DOWN      1
+#define SCAN_SWEEP          2     // Every channel, ensembles go into the multiplex database
+#define SCAN_LIST           3     // Given channels only, stop on the first that locks, else go back
+#define SCAN_LIST_SIZE      8
+
+// Per channel outcome
+#define SCAN_EMPTY          0     // Not VALID after the RSSI window
+#define SCAN_NO_DAB         1     // Carrier, but no DAB fast detect
+#define SCAN_NO_LOCK        2     // DAB detected, never acquired or no FIC
+#define SCAN_NO_LIST        3     // Locked, service list not complete in time
+#define SCAN_ENSEMBLE       4
+
+#define SCAN_POLL           5     // ms between status polls while a channel is undecided
+#define SCAN_STC_TIMEOUT    250   // ms from DAB_TUNE_FREQ to STC
+#define SCAN_DETECT_TIMEOUT 100   // ms from STC to a fast detect
+#define SCAN_ACQ_TIMEOUT    1500  // ms from STC to ACQ, and again from ACQ to FIC
+#define SCAN_LIST_TIMEOUT   3000  // ms a locked channel gets to deliver its ensemble and service list
+
+typedef struct _ScanResult {
+  uint8_t   channel;
+  uint8_t   result;       // SCAN_EMPTY .. SCAN_ENSEMBLE
+  uint16_t  time;         // ms spent on the channel
+  uint8_t   found;        // Ensembles so far
+  bool      last;         // Scan finished, channel is where the tuner stays
+} ScanResult;
+
+typedef void (*ScanCallback)(const ScanResult& result);
+
+void scanStart(uint8_t mode, uint8_t channel, ScanCallback callback);
+void scanStartList(const uint8_t* channels, uint8_t count, uint8_t home, ScanCallback callback);
+void scanStop(void);
+void scanStep(void);
+bool scanActive(void);
+uint16_t scanTime(uint8_t channel);
+uint8_t scanResult(uint8_t channel);
+
+#endif
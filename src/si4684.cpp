@@ -1,26 +1,89 @@
 #include "si4684.h"
+#include "epg.h"
+#include "charset.h"
 #include "mbedtls/base64.h"
 
 unsigned char SPIbuffer[4096];
-uint8_t EPGbuffer[12000];
-uint16_t EPGbufferByteCounter;
-uint8_t EPGbufferIDOld;
 bool once = false;
 
-unsigned long DataUpdate = 0;
+unsigned long jobDue[RADIO_JOBS];
+static const uint16_t jobPeriod[RADIO_JOBS] = {500, 250, 500, 500, 500, 50, 1000, 1000};  // ms, indexed by JOB_*
 unsigned long SlideShowRecoverTimer = 0;
 bool EnsembleInfoSet;
-uint8_t slaveSelectPin;
-bool processEPG;
+Si468xSPI SPIbus;
+Si468xBus* bus = &SPIbus;
+int8_t intPin = -1;
+bool intEnabled;
+volatile bool intPending;
+TaskHandle_t intTask;
+RTC_DATA_ATTR uint16_t warmStart;  // Survives ESP32 deep sleep, the Si4684 stays powered
+RTC_DATA_ATTR uint16_t propertyID[PROPERTY_CACHE_SIZE];
+RTC_DATA_ATTR uint16_t propertyValue[PROPERTY_CACHE_SIZE];
+RTC_DATA_ATTR uint8_t properties;
+uint32_t redundantWrites;
+uint8_t serviceBacklog;
+uint32_t componentService[COMPONENT_CACHE_SIZE];
+uint32_t componentComp[COMPONENT_CACHE_SIZE];
+uint8_t componentType[COMPONENT_CACHE_SIZE];
+uint8_t components;
+bool listComplete;  // Last service list parse got every entry, only then is its version taken as read
+uint32_t labelHash[LABEL_CACHE_SIZE];
+uint8_t labelCharset[LABEL_CACHE_SIZE];
+uint8_t labelLength[LABEL_CACHE_SIZE];
+char labelRaw[LABEL_CACHE_SIZE][17];
+char labelText[LABEL_CACHE_SIZE][LABEL_TEXT_SIZE];
+uint8_t labelNext;
+uint32_t textHash[TEXT_CACHE_SIZE];
+uint8_t textCharset[TEXT_CACHE_SIZE];
+uint8_t textLength[TEXT_CACHE_SIZE];
+char textRaw[TEXT_CACHE_SIZE][128];
+char textText[TEXT_CACHE_SIZE][TEXT_TEXT_SIZE];
+uint8_t textNext;
+bool dlTextToggle;
+bool dlPlusToggle;
+bool dlPlusItemToggle;
+bool dlPlusItemRunning;
+bool dlPlusItemApplied;
+uint8_t dlPlusTags;
+uint8_t dlPlusTag[DLPLUS_TAGS][3];
+bool EPGactive;
+uint8_t EPGsegment;
+uint16_t EPGtransportID;
+uint32_t FIGhash[FIG_CACHE_SIZE];
+uint8_t FIGqueue[FIG_QUEUE_SIZE];
+uint16_t FIGqueueHead;
+uint16_t FIGqueueTail;
+uint16_t FIGqueueFlush;  // Head + 1 at the last tune, the reader drops everything before it
+uint16_t afEId[AF_TABLE_SIZE];
+uint8_t afChannel[AF_TABLE_SIZE];
+uint8_t afCount;
+uint8_t afNext;
+uint32_t oeSId[OE_TABLE_SIZE];
+uint16_t oeEId[OE_TABLE_SIZE];
+uint8_t oeCount;
+uint8_t oeNext;
+uint16_t announcementSupport;
+uint8_t announcementClusters[ANNOUNCEMENT_CLUSTERS];
+uint8_t announcementClusterCount;
+uint8_t announcementCluster;
+unsigned long announcementSeen;
 
 static void SPIwrite(unsigned char* data, uint32_t length);
 static void SPIread(uint16_t length);
 static void cts(void);
+static void hostLoad(const unsigned char* image, uint32_t size);
+static void waitInterrupt(uint32_t timeout);
+static bool serviceDataPending(void);
+static void IRAM_ATTR intISR(void);
 static void Set_Property(uint16_t property, uint16_t value);
-static String convertToUTF8(const wchar_t* input);
-static String extractUTF8Substring(const String& utf8String, size_t start, size_t length);
-static void charConverter(const char* input, wchar_t* output, size_t size);
+static void Set_Properties(const uint16_t (*list)[2], uint8_t count);
 static int compareCompID(const void* a, const void* b);
+static int8_t findComponent(uint32_t serviceID, uint32_t compID);
+static uint16_t crc16(const uint8_t* data, uint16_t length);
+static void decodeFrequencyInformation(const uint8_t* data, uint8_t size);
+static void decodeOtherEnsembles(const uint8_t* data, uint8_t size, bool pd);
+static int8_t channelFromFrequency(uint32_t frequency);
+static void startDigitalService(uint32_t serviceID, uint32_t compID);
 
 char* DAB::getChipID(void) {
   SPIbuffer[0] = 0x08;
@@ -90,12 +153,16 @@ void DAB::vol(uint8_t vol) {
   Set_Property(0x0300, (vol & 0x3F));
 }
 
+Si468xBus* DAB::getBus(void) {
+  return bus;
+}
+
+void DAB::setBus(Si468xBus* newBus) {
+  bus = newBus;
+}
+
 static void SPIwrite(unsigned char* data, uint32_t length) {
-  SPI.beginTransaction(SPISettings(10000000, MSBFIRST, SPI_MODE0));
-  digitalWrite(slaveSelectPin, LOW);
-  SPI.transfer(data, length);
-  digitalWrite(slaveSelectPin, HIGH);
-  SPI.endTransaction();
+  bus->transfer(data, length);
 }
 
 static void SPIread(uint16_t length) {
@@ -103,7 +170,26 @@ static void SPIread(uint16_t length) {
   SPIwrite(SPIbuffer, length + 1);
 }
 
+uint32_t DAB::getRedundantWrites(void) {
+  return redundantWrites;
+}
+
 static void Set_Property(uint16_t property, uint16_t value) {
+  uint8_t slot = 0;
+  while (slot < properties && propertyID[slot] != property) slot++;
+
+  if (slot < properties) {
+    if (propertyValue[slot] == value) {
+      redundantWrites++;
+      return;
+    }
+    propertyValue[slot] = value;
+  } else if (properties < PROPERTY_CACHE_SIZE) {
+    propertyID[properties] = property;
+    propertyValue[properties] = value;
+    properties++;
+  }
+
   SPIbuffer[0] = 0x13;
   SPIbuffer[1] = 0x00;
   SPIbuffer[2] = property & 0xFF;
@@ -114,17 +200,66 @@ static void Set_Property(uint16_t property, uint16_t value) {
   cts();
 }
 
+static void Set_Properties(const uint16_t (*list)[2], uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) Set_Property(list[i][0], list[i][1]);
+}
+
+static void hostLoad(const unsigned char* image, uint32_t size) {
+  // PROGMEM is memory mapped on the ESP32, so chunks go to the bus straight from flash
+  static const uint8_t header[4] = {0x04, 0x00, 0x00, 0x00};  // HOST_LOAD
+
+  for (uint32_t index = 0; index < size; index += HOST_LOAD_SIZE) {
+    bus->write(header, sizeof(header), image + index, min((uint32_t)HOST_LOAD_SIZE, size - index));
+    cts();
+  }
+}
+
+static void IRAM_ATTR intISR(void) {
+  BaseType_t woken = pdFALSE;
+  intPending = true;
+  if (intTask != NULL) vTaskNotifyGiveFromISR(intTask, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static void waitInterrupt(uint32_t timeout) {
+  intTask = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout));
+}
+
+static bool serviceDataPending(void) {
+  if (serviceBacklog > 0) return true;
+  if (!intEnabled) return bitRead(SPIbuffer[1], 4);  // DSRVINT from the last command's status
+
+  if (bitRead(SPIbuffer[1], 4)) return true;  // INTB stays low while packets remain, no new edge
+  if (!intPending) return false;
+  intPending = false;
+  memset(SPIbuffer, 0, 5);
+  SPIwrite(SPIbuffer, 5);
+  return bitRead(SPIbuffer[1], 4);
+}
+
 static void cts(void) {
   bool timeout = false;
-  uint16_t countdown = 200;
+  uint16_t polls = 0;
+  unsigned long start = millis();
+
+  // Most commands complete within microseconds, so read the status before sleeping at all
+  memset(SPIbuffer, 0, 5);
+  SPIwrite(SPIbuffer, 5);
 
   while (!(SPIbuffer[1] & 0x80)) {
-    delay(2);
+    if (intEnabled) {
+      waitInterrupt(2);
+    } else if (polls < 20) {
+      delayMicroseconds(100);
+      polls++;
+    } else {
+      delay(2);
+    }
     memset(SPIbuffer, 0, 5);
     SPIwrite(SPIbuffer, 5);
 
-    countdown--;
-    if (countdown == 0) {
+    if (millis() - start > 400) {
       timeout = true;
       break;
     }
@@ -139,13 +274,18 @@ static void cts(void) {
   }
 }
 
-bool DAB::begin(uint8_t SSpin) {
+bool DAB::begin(uint8_t SSpin, int8_t INTpin, bool warm) {
+  unsigned long start = millis();
+  crashed = false;
   memset(SPIbuffer, 0, sizeof(SPIbuffer));
   if (LittleFS.exists("/temp.img")) LittleFS.remove("/temp.img");
-  slaveSelectPin = SSpin;
-  pinMode(slaveSelectPin, OUTPUT);  // Configure SPI
-  digitalWrite(slaveSelectPin, HIGH);
-  SPI.begin(14, 16, 13, SSpin);
+  bus->begin(SSpin);
+  intEnabled = false;
+  if (intPin < 0 && INTpin >= 0) {
+    pinMode(INTpin, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(INTpin), intISR, FALLING);
+  }
+  intPin = INTpin;
   delay(3);
   SPIbuffer[0] = 0x09;
   SPIbuffer[1] = 0x00;
@@ -160,7 +300,14 @@ bool DAB::begin(uint8_t SSpin) {
     result = true;
   }
 
-  if (SPIbuffer[1] != 2) {
+  // After a standby the DAB image is still running with our band plan and properties
+  WarmStart = (warm && result && warmStart == WARM_START_MAGIC && SPIbuffer[5] == 2);
+  warmStart = 0;
+
+  if (WarmStart) {
+    Set_Property(0x0301, 0x0000);  // Unmute
+  } else {
+    properties = 0;  // Power up brings every property back to its default
     SPIbuffer[0] = 0x01;  // POWER_UP
     SPIbuffer[1] = 0x00;
     SPIbuffer[2] = 0x17;
@@ -187,16 +334,8 @@ bool DAB::begin(uint8_t SSpin) {
     SPIwrite(SPIbuffer, 2);
     cts();
 
-    uint32_t index = 0;  // Write bootloader
-    for (uint16_t i = 0; index < sizeof(rom_patch_016); i++) {
-      SPIbuffer[0] = 0x04;
-      SPIbuffer[1] = 0x00;
-      SPIbuffer[2] = 0x00;
-      SPIbuffer[3] = 0x00;
-      for (uint16_t j = 4; j < 128 && index < sizeof(rom_patch_016); j++, index++) SPIbuffer[j] = pgm_read_byte_near(rom_patch_016 + index);
-      SPIwrite(SPIbuffer, 128);
-      cts();
-    }
+    unsigned long loadstart = millis();
+    hostLoad(rom_patch_016, sizeof(rom_patch_016));  // Write bootloader
 
     delay(4);
     SPIbuffer[0] = 0x06;  // LOAD_INIT
@@ -204,20 +343,8 @@ bool DAB::begin(uint8_t SSpin) {
     SPIwrite(SPIbuffer, 2);
     cts();
 
-    index = 0;
-    uint16_t i = 0;
-    while (index < sizeof(firmware)) {
-      SPIbuffer[0] = 0x04;
-      SPIbuffer[1] = 0x00;
-      SPIbuffer[2] = 0x00;
-      SPIbuffer[3] = 0x00;
-      for (i = 4; (i < 2048) && (index < sizeof(firmware)); i++) {
-        SPIbuffer[i] = pgm_read_byte_near(firmware + index);
-        index++;
-      }
-      SPIwrite(SPIbuffer, i);
-      cts();
-    }
+    hostLoad(firmware, sizeof(firmware));
+    LoadTime = millis() - loadstart;
 
     SPIbuffer[0] = 0x07;  // BOOT
     SPIbuffer[1] = 0x00;
@@ -228,7 +355,7 @@ bool DAB::begin(uint8_t SSpin) {
     SPIbuffer[1] = 0x26;
     SPIbuffer[2] = 0x00;
     SPIbuffer[3] = 0x00;
-    for (i = 0; i < sizeof(DABfrequencyTable_DAB) / sizeof(DABFrequencyLabel_DAB); i++) {
+    for (uint16_t i = 0; i < sizeof(DABfrequencyTable_DAB) / sizeof(DABFrequencyLabel_DAB); i++) {
       SPIbuffer[4 + (i * 4)] = DABfrequencyTable_DAB[i].frequency & 0xFF;
       SPIbuffer[5 + (i * 4)] = (DABfrequencyTable_DAB[i].frequency >> 8) & 0xFF;
       SPIbuffer[6 + (i * 4)] = (DABfrequencyTable_DAB[i].frequency >> 16) & 0xFF;
@@ -237,46 +364,19 @@ bool DAB::begin(uint8_t SSpin) {
     SPIwrite(SPIbuffer, 4 + (38 * 4));
     cts();
 
-    Set_Property(0x0200, 0x8000);  // Set properties
-    Set_Property(0x0202, 0x1600);
-    Set_Property(0x0800, 0x0003);
-    Set_Property(0x1710, 0xFC4A);
-    Set_Property(0x1711, 0x00F8);
-    Set_Property(0x8100, 0x0001);
-    Set_Property(0x8101, 0x0064);
-    Set_Property(0xB200, 0x0000);
-    Set_Property(0xB201, 0x0080);
-    Set_Property(0xB301, 0x0000);
-    Set_Property(0xB302, 0x0000);
-    Set_Property(0xB303, 0x0000);
-    Set_Property(0xB400, 0x0097);
-    Set_Property(0xB401, 0x0002);
-    Set_Property(0xB500, 0x0000);
+    Set_Properties(DABProperties, sizeof(DABProperties) / sizeof(DABProperties[0]));
+  }
+
+  if (intPin >= 0) {
+    Set_Property(0x0000, 0x0091);  // INTB on CTS, DSRVINT and STCINT
+    intEnabled = true;
   }
 
+  BootTime = millis() - start;
   return result;
 }
 
 void DAB::EnsembleInfo(void) {
-  static bool lastSignalLock = false;
-  static uint8_t lastFic = 0;
-
-  SPIbuffer[0] = 0xB2;  // Get signalstatus
-  SPIbuffer[1] = 0x09;
-  SPIwrite(SPIbuffer, 2);
-  cts();
-  SPIread(19);
-  fic = SPIbuffer[9];
-  cnr = SPIbuffer[10];
-  if (fic > 0) signallock = true;
-  else signallock = false;
-
-  // Log signal changes
-  if (signallock != lastSignalLock) {
-    lastSignalLock = signallock;
-  }
-
-  lastFic = fic;
   if (signallock) {
     SPIbuffer[0] = 0x80;  // Get servicelist
     SPIbuffer[1] = 0x00;
@@ -285,75 +385,98 @@ void DAB::EnsembleInfo(void) {
     SPIread(8);
 
     if (SPIbuffer[5] + (SPIbuffer[6] << 8) + 6 < sizeof(SPIbuffer)) {
-      SPIread(SPIbuffer[5] + (SPIbuffer[6] << 8) + 6);
-      uint8_t numberofcomponents;
-
-      numberofservices = SPIbuffer[9];
-      if (numberofservices > sizeof(service) / sizeof(DABService)) {
-        clearData();  // Handle overflow when signal is crappy
-        numberofservices = 0;
-        return;
-      }
-
-      uint16_t offset = 13;
-
-      for (uint8_t i = 0; i < numberofservices; i++) {
-        if (i >= sizeof(service) / sizeof(DABService)) {
-          clearData();  // Handle overflow when signal is crappy
-          numberofservices = 0;
-          return;
-        }
+      uint16_t version = SPIbuffer[7] + (SPIbuffer[8] << 8);
 
-        serviceID = SPIbuffer[offset + 3];
-        serviceID <<= 8;
-        serviceID += SPIbuffer[offset + 2];
-        serviceID <<= 8;
-        serviceID += SPIbuffer[offset + 1];
-        serviceID <<= 8;
-        serviceID += SPIbuffer[offset];
-        componentID = 0;
+      // The list only changes when its version does, skip the parse while it stands still
+      if (numberofservices > 0 && version == ServiceListVersion && !ServiceListCached && listComplete) {
+        ServiceListSkips++;
+      } else {
+        uint16_t listEnd = SPIbuffer[5] + (SPIbuffer[6] << 8) + 6;
+        SPIread(listEnd);
 
-        numberofcomponents = SPIbuffer[offset + 5] & 0x0F;
+        // A new list version may reassign components, ask the chip again for every service
+        if (version != ServiceListVersion) components = 0;
 
-        for (uint16_t j = 0; j < 16; j++) service[i].Label[j] = SPIbuffer[offset + 8 + j];
+        uint8_t count = SPIbuffer[9];
+        uint16_t offset = 13;
+        numberofservices = 0;
+        numberofcomponents = 0;
+        listComplete = true;
 
-        for (int16_t j = 15; j >= 0; j--) {
-          if (service[i].Label[j] == ' ' && service[i].Label[j + 1] == '\0') {
-            service[i].Label[j] = '\0';
-          } else {
+        for (uint8_t i = 0; i < count; i++) {
+          if (offset + 24 > listEnd) {  // Cut short when signal is crappy, keep what was complete
+            listComplete = false;
             break;
           }
-        }
-        offset += 24;
-
-        for (uint16_t j = 0; j < numberofcomponents; j++) {
-          if (j == 0) {
-            componentID = SPIbuffer[offset + 3];
-            componentID <<= 8;
-            componentID += SPIbuffer[offset + 2];
-            componentID <<= 8;
-            componentID += SPIbuffer[offset + 1];
-            componentID <<= 8;
-            componentID += SPIbuffer[offset];
-          }
-          offset += 4;
-        }
-        service[i].ServiceID = serviceID;
-        service[i].CompID = componentID;
-      }
 
+          DABService entry;
+          serviceID = SPIbuffer[offset + 3];
+          serviceID <<= 8;
+          serviceID += SPIbuffer[offset + 2];
+          serviceID <<= 8;
+          serviceID += SPIbuffer[offset + 1];
+          serviceID <<= 8;
+          serviceID += SPIbuffer[offset];
+          componentID = 0;
 
-      if (numberofservices > 0) {
-        qsort(service, numberofservices, sizeof(DABService), compareCompID);
+          uint8_t parts = SPIbuffer[offset + 5] & 0x0F;
 
-        if (CurrentServiceID != service[ServiceIndex].ServiceID) {
-          for (byte x = 0; x < numberofservices; x++) {
-            if (CurrentServiceID == service[x].ServiceID) {
-              ServiceIndex = x;
+          for (uint16_t j = 0; j < 16; j++) entry.Label[j] = SPIbuffer[offset + 8 + j];
+          entry.Label[16] = '\0';
+
+          for (int16_t j = 15; j >= 0; j--) {
+            if (entry.Label[j] == ' ' && entry.Label[j + 1] == '\0') {
+              entry.Label[j] = '\0';
+            } else {
               break;
             }
           }
+          offset += 24;
+
+          if (offset + parts * 4 > listEnd) listComplete = false;
+          for (uint16_t j = 0; j < parts && offset + 4 <= listEnd; j++) {
+            uint32_t id = SPIbuffer[offset + 3];
+            id <<= 8;
+            id += SPIbuffer[offset + 2];
+            id <<= 8;
+            id += SPIbuffer[offset + 1];
+            id <<= 8;
+            id += SPIbuffer[offset];
+            if (j == 0) componentID = id;
+
+            if (numberofcomponents < MAX_COMPONENTS) {
+              int8_t cached = findComponent(serviceID, id);
+              component[numberofcomponents].ServiceID = serviceID;
+              component[numberofcomponents].CompID = id;
+              component[numberofcomponents].ServiceType = (cached < 0) ? 0 : componentType[cached];
+              numberofcomponents++;
+            }
+            offset += 4;
+          }
+
+          if (numberofservices < MAX_SERVICES) {
+            int8_t cached = findComponent(serviceID, componentID);
+            entry.ServiceID = serviceID;
+            entry.CompID = componentID;
+            entry.ServiceType = (cached < 0) ? 0 : componentType[cached];
+
+            // Insert in place, the list comes almost sorted so this rarely moves anything
+            uint8_t position = numberofservices;
+            while (position > 0 && compareCompID(&entry, &service[position - 1]) < 0) {
+              service[position] = service[position - 1];
+              position--;
+            }
+            service[position] = entry;
+            numberofservices++;
+          }
         }
+
+        if (numberofservices > 0 && CurrentServiceID != service[ServiceIndex].ServiceID) {
+          int16_t index = findService(CurrentServiceID);
+          if (index >= 0) ServiceIndex = index;
+        }
+        if (listComplete) ServiceListVersion = version;
+        ServiceListCached = false;
       }
 
       for (byte i = 0; i < 5; i++) SPIbuffer[i] = 0;
@@ -371,7 +494,9 @@ void DAB::EnsembleInfo(void) {
 
         // Only set EID/EnsembleLabel/ECC once after tuning; they don't change on the same frequency
         // This prevents corrupted data during marginal signal from overwriting valid values
-        if (EID[0] == '\0' || EnsembleLabel[0] == '\0') {
+        // A cached identity is replaced by the first live one, the multiplex may have changed since
+        if (EID[0] == '\0' || EnsembleLabel[0] == '\0' || EnsembleCached) {
+          EnsembleCached = false;
           EID[2] = (SPIbuffer[5] & 0xF0) >> 4;
           EID[3] = (SPIbuffer[5] & 0x0F);
           EID[0] = (SPIbuffer[6] & 0xF0) >> 4;
@@ -385,7 +510,7 @@ void DAB::EnsembleInfo(void) {
               EID[i] += 'A' - 10;
             }
           }
-          for (uint8_t i = 0; i < 16 && SPIbuffer[7 + i] != '\0'; i++) {
+          for (uint8_t i = 0; i < 16; i++) {
             EnsembleLabel[i] = static_cast<char>(SPIbuffer[7 + i]);
           }
           EnsembleLabel[16] = '\0';
@@ -406,183 +531,449 @@ void DAB::EnsembleInfo(void) {
         EnsembleInfoSet = false;
       }
     }
-    SPIbuffer[0] = 0xBC;
-    SPIbuffer[1] = 0x00;
-    SPIwrite(SPIbuffer, 2);
-    cts();
-    SPIread(11);
-
-    if (!bitRead(SPIbuffer[1], 6)) {
-      Year = SPIbuffer[5] + ((uint16_t)SPIbuffer[6] << 8);
-      Months = SPIbuffer[7];
-      Days = SPIbuffer[8];
-      Hours = SPIbuffer[9];
-      Minutes = SPIbuffer[10];
-      Seconds = SPIbuffer[11];
-    }
   }
 }
 
+void DAB::getTime(void) {
+  SPIbuffer[0] = 0xBC;
+  SPIbuffer[1] = 0x00;
+  SPIwrite(SPIbuffer, 2);
+  cts();
+  SPIread(11);
+
+  if (!bitRead(SPIbuffer[1], 6)) {
+    Year = SPIbuffer[5] + ((uint16_t)SPIbuffer[6] << 8);
+    Months = SPIbuffer[7];
+    Days = SPIbuffer[8];
+    Hours = SPIbuffer[9];
+    Minutes = SPIbuffer[10];
+    Seconds = SPIbuffer[11];
+  }
+}
+
+void DAB::getSignalStatus(void) {
+  SPIbuffer[0] = 0xB2;  // Get signalstatus
+  SPIbuffer[1] = 0x09;
+  SPIwrite(SPIbuffer, 2);
+  cts();
+  SPIread(19);
+  fic = SPIbuffer[9];
+  cnr = SPIbuffer[10];
+  if (fic > 0) signallock = true;
+  else signallock = false;
+}
+
 void DAB::getServiceData(void) {
+  // Drain what the chip has buffered, up to a budget so one call cannot stall the loop
+  uint8_t packets = 0;
+  while (serviceDataPending()) {
+    if (packets == SERVICE_DATA_BUDGET) {
+      ServiceDataDeferred++;
+      break;
+    }
+    readServiceData();
+    packets++;
+  }
+}
+
+void DAB::readServiceData(void) {
   uint32_t byte_count = 0;
   uint32_t byte_number = 0;
 
-  if (bitRead(SPIbuffer[1], 4)) {
-    SPIbuffer[0] = 0x84;
-    SPIbuffer[1] = 0x01;
-    SPIwrite(SPIbuffer, 2);
-    cts();
-    SPIread(20);
+  SPIbuffer[0] = 0x84;
+  SPIbuffer[1] = 0x01;
+  SPIwrite(SPIbuffer, 2);
+  cts();
+  SPIread(20);
+  serviceBacklog = SPIbuffer[6];  // BUFF_COUNT, packets still waiting in the chip
+  if (bitRead(SPIbuffer[5], 1)) ServiceDataOverflows++;  // DSRV_OVFL_INT, the chip had to drop packets
 
-    if ((SPIbuffer[19] + (SPIbuffer[20] << 8)) + 24 < sizeof(SPIbuffer)) {
-      if ((SPIbuffer[19] + (SPIbuffer[20] << 8)) > 0) {
-        cts();
-        SPIread((SPIbuffer[19] + (SPIbuffer[20] << 8)) + 24);
-        byte_count = SPIbuffer[19] + (SPIbuffer[20] << 8);
+  if ((SPIbuffer[19] + (SPIbuffer[20] << 8)) + 24 < sizeof(SPIbuffer)) {
+    if ((SPIbuffer[19] + (SPIbuffer[20] << 8)) > 0) {
+      cts();
+      SPIread((SPIbuffer[19] + (SPIbuffer[20] << 8)) + 24);
+      byte_count = SPIbuffer[19] + (SPIbuffer[20] << 8);
+      uint32_t packetCompID = SPIbuffer[13] | ((uint32_t)SPIbuffer[14] << 8) | ((uint32_t)SPIbuffer[15] << 16) | ((uint32_t)SPIbuffer[16] << 24);
+
+      // Read FIC, the payload is a sequence of 32 byte FIBs
+      if (FICServiceCheck != 0 && packetCompID == FICServiceCheck) {
+        for (uint16_t fib = 0; fib + 32 <= byte_count; fib += 32) parseFIB(&SPIbuffer[25 + fib]);
 
         // Read Radiotext
-        if (((SPIbuffer[8] >> 6) & 0x03) == 0x02 && !((SPIbuffer[25] & 0x10) == 0x10)) {
-          for (byte_number = 0; byte_number < byte_count; byte_number++) ServiceData[byte_number] = (char)SPIbuffer[27 + byte_number];
-          ServiceData[byte_number] = '\0';
-
-          // Read Slideshow header - extract total length
-        } else if (((SPIbuffer[8] >> 6) & 0x03) == 0x01 && SPIbuffer[27] == 0x80 && SPIbuffer[28] == 0x00 && SPIbuffer[29] == 0x12 && byte_count < 200) {
-          uint16_t transportID = (SPIbuffer[30] << 8) | SPIbuffer[31];
-          uint32_t newLength = (((uint16_t)SPIbuffer[35] << 12) | ((uint16_t)SPIbuffer[36] << 4) | ((uint16_t)SPIbuffer[37] >> 4)) & 0x00FFFF;
-
-          if (newLength > 0 && newLength != SlideShowLengthOld) {
-            if (SlideShowLength == 0) {
-              // First header - set length and lock onto this image
-              SlideShowLength = newLength;
-
-              // If segments were collected with a different TID, discard them
-              if (SlideShowTransportID != 0 && transportID != SlideShowTransportID) {
-                if (SlideShowDebug) Serial.printf("[SLS] Header TID=%u != segments TID=%u, discarding old segments\n", transportID, SlideShowTransportID);
-                uint8_t maxSeg = SlideShowHighestSegment;
-                for (uint8_t i = 0; i <= maxSeg + 10 && i < 255; i++) {
-                  String segFile = "/seg_" + String(i) + ".bin";
-                  if (LittleFS.exists(segFile)) LittleFS.remove(segFile);
-                }
-                if (LittleFS.exists("/temp.img")) LittleFS.remove("/temp.img");
-                SlideShowByteCounter = 0;
-                SlideShowHighestSegment = 0;
-                SlideShowTotalSegments = 0;
-                SlideShowInit = false;
-                memset(SlideShowSegmentBitmap, 0, sizeof(SlideShowSegmentBitmap));
+      } else if (((SPIbuffer[8] >> 6) & 0x03) == 0x02 && !((SPIbuffer[25] & 0x10) == 0x10)) {
+        for (byte_number = 0; byte_number < byte_count && byte_number < sizeof(ServiceData) - 1; byte_number++) ServiceData[byte_number] = (char)SPIbuffer[27 + byte_number];
+        ServiceData[byte_number] = '\0';
+        dlTextToggle = bitRead(SPIbuffer[25], 7);
+        applyDLPlus();
+
+        // Read DL Plus command
+      } else if (((SPIbuffer[8] >> 6) & 0x03) == 0x02 && (SPIbuffer[25] & 0x1F) == 0x12) {
+        parseDLPlus(&SPIbuffer[25]);
+
+        // Read Slideshow header - extract total length
+      } else if (((SPIbuffer[8] >> 6) & 0x03) == 0x01 && SPIbuffer[27] == 0x80 && SPIbuffer[28] == 0x00 && SPIbuffer[29] == 0x12 && byte_count < 200) {
+        uint16_t transportID = (SPIbuffer[30] << 8) | SPIbuffer[31];
+        uint32_t newLength = (((uint16_t)SPIbuffer[35] << 12) | ((uint16_t)SPIbuffer[36] << 4) | ((uint16_t)SPIbuffer[37] >> 4)) & 0x00FFFF;
+
+        if (newLength > 0 && newLength != SlideShowLengthOld) {
+          if (SlideShowLength == 0) {
+            // First header - set length and lock onto this image
+            SlideShowLength = newLength;
+
+            // If segments were collected with a different TID, discard them
+            if (SlideShowTransportID != 0 && transportID != SlideShowTransportID) {
+              if (SlideShowDebug) Serial.printf("[SLS] Header TID=%u != segments TID=%u, discarding old segments\n", transportID, SlideShowTransportID);
+              uint8_t maxSeg = SlideShowHighestSegment;
+              for (uint8_t i = 0; i <= maxSeg + 10 && i < 255; i++) {
+                String segFile = "/seg_" + String(i) + ".bin";
+                if (LittleFS.exists(segFile)) LittleFS.remove(segFile);
               }
+              if (LittleFS.exists("/temp.img")) LittleFS.remove("/temp.img");
+              SlideShowByteCounter = 0;
+              SlideShowHighestSegment = 0;
+              SlideShowTotalSegments = 0;
+              SlideShowInit = false;
+              memset(SlideShowSegmentBitmap, 0, sizeof(SlideShowSegmentBitmap));
+            }
 
-              SlideShowTransportID = transportID;
-              SlideShowNew = true;
-              SlideShowInit = true;
-              if (SlideShowDebug) Serial.printf("[SLS] Header received, length=%u, bytes so far=%u, TID=%u\n", SlideShowLength, SlideShowByteCounter, transportID);
-
-              if (SlideShowByteCounter >= SlideShowLength && allSegmentsReceived()) {
-                SlideShowTotalSegments = SlideShowHighestSegment + 1;
-                if (SlideShowDebug) Serial.printf("[SLS] All segments ready after header, assembling %u segments\n", SlideShowTotalSegments);
-                assembleSlideshow();
-              }
-            } else if (SlideShowLength == newLength) {
-              // Same image, new carousel cycle - update TID to accept segments again
-              SlideShowTransportID = transportID;
-              if (SlideShowDebug) Serial.printf("[SLS] Header confirmed, length=%u, bytes so far=%u, TID=%u\n", SlideShowLength, SlideShowByteCounter, transportID);
+            SlideShowTransportID = transportID;
+            SlideShowNew = true;
+            SlideShowInit = true;
+            if (SlideShowDebug) Serial.printf("[SLS] Header received, length=%u, bytes so far=%u, TID=%u\n", SlideShowLength, SlideShowByteCounter, transportID);
+
+            if (SlideShowByteCounter >= SlideShowLength && allSegmentsReceived()) {
+              SlideShowTotalSegments = SlideShowHighestSegment + 1;
+              if (SlideShowDebug) Serial.printf("[SLS] All segments ready after header, assembling %u segments\n", SlideShowTotalSegments);
+              assembleSlideshow();
+            }
+          } else if (SlideShowLength == newLength) {
+            // Same image, new carousel cycle - update TID to accept segments again
+            SlideShowTransportID = transportID;
+            if (SlideShowDebug) Serial.printf("[SLS] Header confirmed, length=%u, bytes so far=%u, TID=%u\n", SlideShowLength, SlideShowByteCounter, transportID);
 
-              if (SlideShowByteCounter >= SlideShowLength && allSegmentsReceived()) {
-                SlideShowTotalSegments = SlideShowHighestSegment + 1;
-                if (SlideShowDebug) Serial.printf("[SLS] All segments ready after header, assembling %u segments\n", SlideShowTotalSegments);
-                assembleSlideshow();
-              }
-            } else {
-              // Different length - other carousel image, ignore
-              if (SlideShowDebug) Serial.printf("[SLS] Ignoring header length=%u (collecting %u), TID=%u\n", newLength, SlideShowLength, transportID);
+            if (SlideShowByteCounter >= SlideShowLength && allSegmentsReceived()) {
+              SlideShowTotalSegments = SlideShowHighestSegment + 1;
+              if (SlideShowDebug) Serial.printf("[SLS] All segments ready after header, assembling %u segments\n", SlideShowTotalSegments);
+              assembleSlideshow();
             }
+          } else {
+            // Different length - other carousel image, ignore
+            if (SlideShowDebug) Serial.printf("[SLS] Ignoring header length=%u (collecting %u), TID=%u\n", newLength, SlideShowLength, transportID);
           }
+        }
 
-          // Read Slideshow packets - store each segment (works with or without header)
-        } else if (((SPIbuffer[8] >> 6) & 0x03) == 0x01 && (SPIbuffer[27] == 0x00 || SPIbuffer[27] == 0x80) && SPIbuffer[29] == 0x12) {
-          uint16_t transportID = (SPIbuffer[30] << 8) | SPIbuffer[31];
-          uint8_t segmentNumber = SPIbuffer[28];
-
-          // Check Transport ID
-          if (SlideShowTransportID == 0) {
-            SlideShowTransportID = transportID;
-            if (SlideShowDebug) Serial.printf("[SLS] Transport ID set to %u\n", transportID);
-          } else if (transportID != SlideShowTransportID) {
-            // Different carousel object - skip this segment, don't reset
-            if (SlideShowDebug) Serial.printf("[SLS] Skipping segment %u, TID=%u (collecting TID=%u)\n", segmentNumber, transportID, SlideShowTransportID);
-          }
+        // Read Slideshow packets - store each segment (works with or without header)
+      } else if (((SPIbuffer[8] >> 6) & 0x03) == 0x01 && (SPIbuffer[27] == 0x00 || SPIbuffer[27] == 0x80) && SPIbuffer[29] == 0x12) {
+        uint16_t transportID = (SPIbuffer[30] << 8) | SPIbuffer[31];
+        uint8_t segmentNumber = SPIbuffer[28];
+
+        // Check Transport ID
+        if (SlideShowTransportID == 0) {
+          SlideShowTransportID = transportID;
+          if (SlideShowDebug) Serial.printf("[SLS] Transport ID set to %u\n", transportID);
+        } else if (transportID != SlideShowTransportID) {
+          // Different carousel object - skip this segment, don't reset
+          if (SlideShowDebug) Serial.printf("[SLS] Skipping segment %u, TID=%u (collecting TID=%u)\n", segmentNumber, transportID, SlideShowTransportID);
+        }
 
-          if (transportID == SlideShowTransportID) {
-            uint8_t byteIndex = segmentNumber / 8;
-            uint8_t bitIndex = segmentNumber % 8;
-
-            // Check if we already have this segment
-            if (!(SlideShowSegmentBitmap[byteIndex] & (1 << bitIndex))) {
-              uint16_t dataLen = byte_count - 11;
-
-              // Ensure enough free space for segment (with margin)
-              ensureFreeSpace(dataLen + 4096);
-
-              // Save segment to individual file
-              String segFile = "/seg_" + String(segmentNumber) + ".bin";
-              File slideshowFile = LittleFS.open(segFile, "wb");
-              if (slideshowFile) {
-                slideshowFile.write(&SPIbuffer[34], dataLen);
-                slideshowFile.close();
-
-                // Mark segment as received and update highest seen
-                SlideShowSegmentBitmap[byteIndex] |= (1 << bitIndex);
-                SlideShowByteCounter += dataLen;
-                if (segmentNumber > SlideShowHighestSegment) {
-                  SlideShowHighestSegment = segmentNumber;
-                }
-                SlideShowInit = true;
-                if (SlideShowDebug) Serial.printf("[SLS] Segment %u saved, %u bytes (total %u/%u) TID=%u\n", segmentNumber, dataLen, SlideShowByteCounter, SlideShowLength, transportID);
-
-                // Check if complete - using byte count + all segments when we have header length
-                if (SlideShowLength > 0 && SlideShowByteCounter >= SlideShowLength && allSegmentsReceived()) {
-                  SlideShowTotalSegments = SlideShowHighestSegment + 1;
-                  if (SlideShowDebug) Serial.printf("[SLS] Complete by byte count, assembling %u segments\n", SlideShowTotalSegments);
-                  assembleSlideshow();
-                }
+        if (transportID == SlideShowTransportID) {
+          uint8_t byteIndex = segmentNumber / 8;
+          uint8_t bitIndex = segmentNumber % 8;
+
+          // Check if we already have this segment
+          if (!(SlideShowSegmentBitmap[byteIndex] & (1 << bitIndex))) {
+            uint16_t dataLen = byte_count - 11;
+
+            // Ensure enough free space for segment (with margin)
+            ensureFreeSpace(dataLen + 4096);
+
+            // Save segment to individual file
+            String segFile = "/seg_" + String(segmentNumber) + ".bin";
+            File slideshowFile = LittleFS.open(segFile, "wb");
+            if (slideshowFile) {
+              slideshowFile.write(&SPIbuffer[34], dataLen);
+              slideshowFile.close();
+
+              // Mark segment as received and update highest seen
+              SlideShowSegmentBitmap[byteIndex] |= (1 << bitIndex);
+              SlideShowByteCounter += dataLen;
+              if (segmentNumber > SlideShowHighestSegment) {
+                SlideShowHighestSegment = segmentNumber;
               }
-            } else if (segmentNumber == 0 && SlideShowLength == 0 && SlideShowHighestSegment > 0) {
-              // Segment 0 received again (duplicate) - a full broadcast cycle has completed
-              if (SlideShowDebug) Serial.printf("[SLS] Segment 0 repeated, highest=%u\n", SlideShowHighestSegment);
-              if (allSegmentsReceived()) {
+              SlideShowInit = true;
+              if (SlideShowDebug) Serial.printf("[SLS] Segment %u saved, %u bytes (total %u/%u) TID=%u\n", segmentNumber, dataLen, SlideShowByteCounter, SlideShowLength, transportID);
+
+              // Check if complete - using byte count + all segments when we have header length
+              if (SlideShowLength > 0 && SlideShowByteCounter >= SlideShowLength && allSegmentsReceived()) {
                 SlideShowTotalSegments = SlideShowHighestSegment + 1;
-                if (SlideShowDebug) Serial.printf("[SLS] Complete by cycle detection, assembling %u segments\n", SlideShowTotalSegments);
+                if (SlideShowDebug) Serial.printf("[SLS] Complete by byte count, assembling %u segments\n", SlideShowTotalSegments);
                 assembleSlideshow();
               }
             }
-          }
-        } else if (((SPIbuffer[8] >> 6) & 0x03) == 0x00) {
-          if (SPIbuffer[28] == 0x00 && SPIbuffer[34] == 0x02) processEPG = true;
-          else if (SPIbuffer[28] == 0x00 && SPIbuffer[34] != 0x02) processEPG = false;
-
-          if (EPGbufferByteCounter != 0 && SPIbuffer[31] != EPGbufferIDOld && EPGbuffer[0] == 0x02) parseEPG();
-
-          if (processEPG) {
-            EPGbufferIDOld = SPIbuffer[31];
-            if (EPGbufferByteCounter + (byte_count - 11) <= sizeof(EPGbuffer)) {
-              for (byte_number = 0; byte_number < byte_count - 11; byte_number++) {
-                EPGbuffer[EPGbufferByteCounter] = SPIbuffer[34 + byte_number];
-                EPGbufferByteCounter++;
-              }
-            } else {
-              processEPG = false;
-              EPGbufferByteCounter = 0;
+          } else if (segmentNumber == 0 && SlideShowLength == 0 && SlideShowHighestSegment > 0) {
+            // Segment 0 received again (duplicate) - a full broadcast cycle has completed
+            if (SlideShowDebug) Serial.printf("[SLS] Segment 0 repeated, highest=%u\n", SlideShowHighestSegment);
+            if (allSegmentsReceived()) {
+              SlideShowTotalSegments = SlideShowHighestSegment + 1;
+              if (SlideShowDebug) Serial.printf("[SLS] Complete by cycle detection, assembling %u segments\n", SlideShowTotalSegments);
+              assembleSlideshow();
             }
-          } else {
-            EPGbufferByteCounter = 0;
           }
         }
+      } else if (((SPIbuffer[8] >> 6) & 0x03) == 0x00) {
+        if (byte_count > 11) parseEPG(&SPIbuffer[34], byte_count - 11, SPIbuffer[28], (SPIbuffer[30] << 8) | SPIbuffer[31]);
+      }
+    }
+  } else {
+    ServiceDataDropped++;  // Larger than SPIbuffer
+  }
+}
+
+// DL command prefix, then CId, item toggle, item running and tag count, then content type, start and length - 1 per tag
+void DAB::parseDLPlus(const uint8_t* data) {
+  uint8_t length = (data[1] & 0x0F) + 1;
+  if ((data[2] >> 4) != 0) return;  // Only the tags command is used
+
+  uint8_t tags = (data[2] & 0x03) + 1;
+  if (1 + tags * 3 > length) return;
+
+  dlPlusToggle = bitRead(data[0], 7);
+  dlPlusItemToggle = bitRead(data[2], 3);
+  dlPlusItemRunning = bitRead(data[2], 2);
+  dlPlusTags = tags;
+  for (uint8_t x = 0; x < tags; x++) {
+    dlPlusTag[x][0] = data[3 + x * 3] & 0x7F;
+    dlPlusTag[x][1] = data[4 + x * 3] & 0x7F;
+    dlPlusTag[x][2] = (data[5 + x * 3] & 0x7F) + 1;
+  }
+  applyDLPlus();
+}
+
+// Tags only describe the label sent with the same toggle bit, whichever of the two arrives last applies them
+void DAB::applyDLPlus(void) {
+  DLPlusView fields[DLPLUS_FIELDS];
+  memset(fields, 0, sizeof(fields));
+  bool running = false;
+
+  if (dlPlusTags > 0 && dlPlusToggle == dlTextToggle) {
+    uint8_t size = strlen(ServiceData);
+    running = dlPlusItemRunning;
+    for (uint8_t x = 0; x < dlPlusTags; x++) {
+      int8_t field = -1;
+      switch (dlPlusTag[x][0]) {
+        case 1: if (running) field = DLPLUS_TITLE; break;
+        case 2: if (running) field = DLPLUS_ALBUM; break;
+        case 4: if (running) field = DLPLUS_ARTIST; break;
+        case 33: field = DLPLUS_PROGRAMME; break;
+      }
+      if (field >= 0 && dlPlusTag[x][1] + dlPlusTag[x][2] <= size) {
+        fields[field].Start = dlPlusTag[x][1];
+        fields[field].Length = dlPlusTag[x][2];
       }
     }
   }
+
+  // A flipped item toggle is a new item even when its text did not change
+  if (running != DLPlusItemRunning || dlPlusItemToggle != dlPlusItemApplied || memcmp(fields, DLPlus, sizeof(fields)) != 0) {
+    memcpy(DLPlus, fields, sizeof(fields));
+    DLPlusItemRunning = running;
+    dlPlusItemApplied = dlPlusItemToggle;
+    DLPlusGeneration++;
+  }
+}
+
+void DAB::clearDLPlus(void) {
+  dlPlusTags = 0;
+  applyDLPlus();
 }
 
-void DAB::parseEPG(void) {
-  // To do
+const char* DAB::DLPlusText(const char* text, const DLPlusView& view, uint8_t charset) {
+  char field[sizeof(ServiceData)];
+  uint8_t length = min(view.Length, (uint8_t)(sizeof(field) - 1));
+  memcpy(field, &text[view.Start], length);
+  field[length] = '\0';
+  return label(field, charset, sizeof(field));
+}
+
+void DAB::parseFIB(const uint8_t* fib) {
+  if (crc16(fib, 30) != ((fib[30] << 8) | fib[31])) return;
+
+  uint8_t offset = 0;
+  while (offset < 30 && fib[offset] != 0xFF) {
+    uint8_t length = fib[offset] & 0x1F;
+    if (length == 0 || offset + 1 + length > 30) break;
+    decodeFIG(&fib[offset], length + 1);
+    parseFIG(&fib[offset], length + 1);
+    offset += length + 1;
+  }
+}
+
+void DAB::parseFIG(const uint8_t* fig, uint8_t length) {
+  if (!FICStream) return;
+
+  uint8_t type = fig[0] >> 5;
+  if (!bitRead(FIGTypeMask, type)) return;
+  if (type == 0 && !bitRead(FIG0ExtMask, fig[1] & 0x1F)) return;
+
+  // FIGs repeat many times a second, only forward the ones not seen recently
+  uint32_t hash = 2166136261UL;
+  for (uint8_t i = 0; i < length; i++) hash = (hash ^ fig[i]) * 16777619UL;
+  if (hash == 0) hash = 1;
+  if (FIGhash[hash % FIG_CACHE_SIZE] == hash) {
+    FIGDuplicates++;
+    return;
+  }
+  FIGhash[hash % FIG_CACHE_SIZE] = hash;
+
+  // Single producer ring, the host side drains it with getFIG() without taking the radio lock
+  uint16_t head = FIGqueueHead;
+  uint16_t used = (head + FIG_QUEUE_SIZE - __atomic_load_n(&FIGqueueTail, __ATOMIC_ACQUIRE)) % FIG_QUEUE_SIZE;
+  if (used + length + 1 >= FIG_QUEUE_SIZE) return;
+
+  FIGqueue[head] = length;
+  head = (head + 1) % FIG_QUEUE_SIZE;
+  for (uint8_t i = 0; i < length; i++) {
+    FIGqueue[head] = fig[i];
+    head = (head + 1) % FIG_QUEUE_SIZE;
+  }
+  __atomic_store_n(&FIGqueueHead, head, __ATOMIC_RELEASE);
+  FIGForwarded++;
+}
+
+// The FIGs the driver acts on itself, whether or not they are forwarded to the host
+void DAB::decodeFIG(const uint8_t* fig, uint8_t length) {
+  if ((fig[0] >> 5) != 0 || length < 3) return;
+
+  switch (fig[1] & 0x1F) {
+    case 18: decodeAnnouncementSupport(&fig[2], length - 2); break;
+    case 19: decodeAnnouncementSwitching(&fig[2], length - 2); break;
+    case 21: decodeFrequencyInformation(&fig[2], length - 2); break;
+    case 24: decodeOtherEnsembles(&fig[2], length - 2, bitRead(fig[1], 5)); break;
+  }
+}
+
+// FIG 0/18: announcement types and clusters per service, only the running service is kept
+void DAB::decodeAnnouncementSupport(const uint8_t* data, uint8_t size) {
+  uint8_t offset = 0;
+  while (offset + 5 <= size) {
+    uint16_t sid = (data[offset] << 8) | data[offset + 1];
+    uint16_t support = (data[offset + 2] << 8) | data[offset + 3];
+    uint8_t clusters = data[offset + 4] & 0x1F;
+    offset += 5;
+    if (offset + clusters > size) return;
+
+    if (ServiceStart && sid == (CurrentServiceID & 0xFFFF)) {
+      announcementSupport = support;
+      announcementClusterCount = min(clusters, (uint8_t)ANNOUNCEMENT_CLUSTERS);
+      memcpy(announcementClusters, &data[offset], announcementClusterCount);
+    }
+    offset += clusters;
+  }
+}
+
+// FIG 0/19: switch to the announced subchannel straight from the FIC, back to the service when it ends
+void DAB::decodeAnnouncementSwitching(const uint8_t* data, uint8_t size) {
+  uint8_t offset = 0;
+  while (offset + 4 <= size) {
+    unsigned long start = micros();
+    uint8_t cluster = data[offset];
+    uint16_t flags = (data[offset + 1] << 8) | data[offset + 2];
+    uint8_t subchannel = data[offset + 3] & 0x3F;
+    offset += bitRead(data[offset + 3], 6) ? 5 : 4;  // Region flag adds a region id, regions are not filtered
+
+    bool member = false;
+    for (uint8_t i = 0; i < announcementClusterCount; i++) if (announcementClusters[i] == cluster) member = true;
+    if (!member) continue;
+
+    uint16_t wanted = flags & announcementSupport & AnnouncementMask;
+    if (AnnouncementActive) {
+      if (cluster != announcementCluster) continue;
+      if (wanted) announcementSeen = millis(); else endAnnouncement();
+      continue;
+    }
+    if (!wanted || subchannel == (service[ServiceIndex].CompID & 0x3F)) continue;
+
+    for (uint8_t x = 0; x < numberofcomponents; x++) {
+      if ((component[x].CompID & 0x3F) == subchannel && component[x].ServiceType != 3 && component[x].ServiceType != 6) {
+        startDigitalService(component[x].ServiceID, component[x].CompID);
+        AnnouncementLatency = micros() - start;
+        AnnouncementActive = true;
+        AnnouncementType = wanted;
+        announcementCluster = cluster;
+        announcementSeen = millis();
+        Announcements++;
+        break;
+      }
+    }
+  }
+}
+
+void DAB::endAnnouncement(void) {
+  if (!AnnouncementActive) return;
+  AnnouncementActive = false;
+  AnnouncementType = 0;
+  if (ServiceStart) startDigitalService(service[ServiceIndex].ServiceID, service[ServiceIndex].CompID);
+}
+
+// Channels that may carry the service: other frequencies of this ensemble and of the ensembles FIG 0/24 lists for it
+uint8_t DAB::getAlternatives(uint32_t ServiceID, uint8_t* channels, uint8_t size) {
+  uint16_t eids[OE_TABLE_SIZE + 1];
+  uint8_t ensembles = 0;
+  eids[ensembles++] = strtoul(EID, NULL, 16);
+  for (uint8_t i = 0; i < oeCount; i++) {
+    if ((oeSId[i] & 0xFFFF) == (ServiceID & 0xFFFF)) eids[ensembles++] = oeEId[i];
+  }
+
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < afCount && count < size; i++) {
+    bool wanted = false;
+    for (uint8_t e = 0; e < ensembles; e++) if (afEId[i] == eids[e]) wanted = true;
+    for (uint8_t c = 0; c < count; c++) if (channels[c] == afChannel[i]) wanted = false;
+    if (wanted) channels[count++] = afChannel[i];
+  }
+  return count;
+}
+
+// The only consumer of the FIG ring, safe to call from another task than the one running Update()
+uint16_t DAB::getFIG(uint8_t* buffer, uint16_t size) {
+  uint16_t tail = FIGqueueTail;
+  uint16_t flush = __atomic_exchange_n(&FIGqueueFlush, 0, __ATOMIC_ACQ_REL);
+  if (flush != 0) {
+    tail = flush - 1;
+    __atomic_store_n(&FIGqueueTail, tail, __ATOMIC_RELEASE);
+  }
+  if (tail == __atomic_load_n(&FIGqueueHead, __ATOMIC_ACQUIRE)) return 0;
+
+  uint8_t length = FIGqueue[tail];
+  if (length > size) return 0;
+
+  tail = (tail + 1) % FIG_QUEUE_SIZE;
+  for (uint8_t i = 0; i < length; i++) {
+    buffer[i] = FIGqueue[tail];
+    tail = (tail + 1) % FIG_QUEUE_SIZE;
+  }
+  __atomic_store_n(&FIGqueueTail, tail, __ATOMIC_RELEASE);
+  return length;
+}
+
+// Segments go straight into the tokenizer, an object is followed only while they arrive in order
+void DAB::parseEPG(const uint8_t* data, uint16_t length, uint8_t segment, uint16_t transportID) {
+  if (segment == 0) {
+    if (EPGactive) epgAbort();
+    EPGactive = (data[0] == 0x02);
+    if (!EPGactive) return;
+    EPGtransportID = transportID;
+    epgBegin(service[ServiceIndex].ServiceID);
+  } else if (EPGactive && transportID == EPGtransportID && segment == EPGsegment) {
+    return;  // Repeated segment
+  } else if (!EPGactive || transportID != EPGtransportID || segment != (uint8_t)(EPGsegment + 1)) {
+    if (EPGactive) epgAbort();
+    EPGactive = false;
+    return;
+  }
+
+  EPGsegment = segment;
+  if (!epgFeed(data, length)) EPGactive = false;
 }
 
 bool DAB::allSegmentsReceived(void) {
@@ -819,26 +1210,72 @@ String DAB::getDynamicFilename(void) {
   return String(serviceID, HEX) + ".img";
 }
 
-void DAB::ServiceInfo(void) {
-  for (byte x = 0; x < numberofservices; x++) {
-    SPIbuffer[0] = 0xBE;
-    SPIbuffer[1] = 0x00;
-    SPIbuffer[2] = 0x00;
-    SPIbuffer[3] = 0x00;
-    SPIbuffer[4] = service[x].ServiceID & 0xFF;
-    SPIbuffer[5] = (service[x].ServiceID >> 8) & 0xFF;
-    SPIbuffer[6] = (service[x].ServiceID >> 16) & 0xFF;
-    SPIbuffer[7] = (service[x].ServiceID >> 24) & 0xFF;
-    SPIbuffer[8] = service[x].CompID & 0xFF;
-    SPIbuffer[9] = (service[x].CompID >> 8) & 0xFF;
-    SPIbuffer[10] = (service[x].CompID >> 16) & 0xFF;
-    SPIbuffer[11] = (service[x].CompID >> 24) & 0xFF;
-    SPIwrite(SPIbuffer, 12);
-    cts();
-    SPIread(12);
-    service[x].ServiceType = SPIbuffer[5];
+void DAB::ComponentInfo(void) {
+  // One uncached component per call, nothing goes over SPI once the whole list is known
+  byte x;
+  for (x = 0; x < numberofcomponents; x++) {
+    if (findComponent(component[x].ServiceID, component[x].CompID) < 0) break;
+  }
+  if (x == numberofcomponents || components >= COMPONENT_CACHE_SIZE) return;
+
+  SPIbuffer[0] = 0xBE;
+  SPIbuffer[1] = 0x00;
+  SPIbuffer[2] = 0x00;
+  SPIbuffer[3] = 0x00;
+  SPIbuffer[4] = component[x].ServiceID & 0xFF;
+  SPIbuffer[5] = (component[x].ServiceID >> 8) & 0xFF;
+  SPIbuffer[6] = (component[x].ServiceID >> 16) & 0xFF;
+  SPIbuffer[7] = (component[x].ServiceID >> 24) & 0xFF;
+  SPIbuffer[8] = component[x].CompID & 0xFF;
+  SPIbuffer[9] = (component[x].CompID >> 8) & 0xFF;
+  SPIbuffer[10] = (component[x].CompID >> 16) & 0xFF;
+  SPIbuffer[11] = (component[x].CompID >> 24) & 0xFF;
+  SPIwrite(SPIbuffer, 12);
+  cts();
+  SPIread(12);
+  component[x].ServiceType = SPIbuffer[5];
+
+  componentService[components] = component[x].ServiceID;
+  componentComp[components] = component[x].CompID;
+  componentType[components] = component[x].ServiceType;
+  components++;
+
+  int16_t index = findService(component[x].ServiceID);
+  if (index >= 0 && service[index].CompID == component[x].CompID) {
+    service[index].ServiceType = component[x].ServiceType;
+    ComponentGeneration++;
+  }
+}
+
+// A list restored from flash brings its component types along, a live list of the same version keeps them
+void DAB::setCachedList(uint16_t version) {
+  components = 0;
+  for (uint8_t x = 0; x < numberofcomponents && components < COMPONENT_CACHE_SIZE; x++) {
+    componentService[components] = component[x].ServiceID;
+    componentComp[components] = component[x].CompID;
+    componentType[components] = component[x].ServiceType;
+    components++;
+  }
+  ServiceListVersion = version;
+  ServiceListCached = true;
+  EnsembleCached = true;
+}
+
+bool DAB::getComponentsKnown(void) {
+  for (uint8_t x = 0; x < numberofcomponents; x++) {
+    if (findComponent(component[x].ServiceID, component[x].CompID) < 0) return false;
   }
+  return true;
+}
+
+int16_t DAB::findService(uint32_t ServiceID) {
+  for (uint8_t x = 0; x < numberofservices; x++) {
+    if (service[x].ServiceID == ServiceID) return x;
+  }
+  return -1;
+}
 
+void DAB::ServiceInfo(void) {
   if (ServiceStart) {
     SPIbuffer[0] = 0xBD;
     SPIbuffer[1] = 0x00;
@@ -911,19 +1348,44 @@ void DAB::ServiceInfo(void) {
 }
 
 void DAB::clearData(void) {
-  for (byte x = 0; x < 32; x++) {
+  numberofcomponents = 0;
+  for (byte x = 0; x < MAX_SERVICES; x++) {
     service[x].ServiceID = 0;
     service[x].CompID = 0;
     service[x].ServiceType = 0;
     for (byte y = 0; y < 16; y++) service[x].Label[y] = '\0';
   }
   for (byte x = 0; x < 128; x++) ServiceData[x] = '\0';
+  clearDLPlus();
 }
 
 void DAB::setFreq(uint8_t freq) {
+  tuneStart(freq);
+
+  unsigned long start = millis();
+  while (!tuneDone()) {
+    if (intEnabled) waitInterrupt(20); else delay(5);
+    if (millis() - start > 5000) {
+      break;
+    }
+  }
+
+  SPIbuffer[0] = 0xB2;
+  SPIbuffer[1] = 0x01;
+  SPIwrite(SPIbuffer, 2);
+  cts();
+  SPIread(6);
+  signalvalid = bitRead(SPIbuffer[6], 0);
+}
+
+// Clears everything of the previous ensemble and sends DAB_TUNE_FREQ, tuneDone() reports the STC
+void DAB::tuneStart(uint8_t freq) {
   memset(SPIbuffer, 0, sizeof(SPIbuffer));
-  DataUpdate -= 1000;
+  for (uint8_t job = 0; job < RADIO_JOBS; job++) jobDue[job] = millis();  // Everything due right after a tune
   numberofservices = 0;
+  components = 0;
+  ServiceListCached = false;
+  EnsembleCached = false;
   clearData();
 
   for (byte x = 0; x < 16; x++) {
@@ -940,6 +1402,17 @@ void DAB::setFreq(uint8_t freq) {
   protectionlevel = 0;
   bitrate = 0;
   dataServiceCheck = 0;
+  FICServiceCheck = 0;
+  serviceBacklog = 0;
+  announcementClusterCount = 0;
+  AnnouncementActive = false;
+  AnnouncementType = 0;
+  afCount = 0;  // Alternatives belong to the ensemble they were heard on
+  afNext = 0;
+  oeCount = 0;
+  oeNext = 0;
+  __atomic_store_n(&FIGqueueFlush, FIGqueueHead + 1, __ATOMIC_RELEASE);  // The tail belongs to getFIG()
+  memset(FIGhash, 0, sizeof(FIGhash));
   ServiceStart = false;
   SlideShowInit = false;
   SlideShowAvailable = false;
@@ -953,22 +1426,56 @@ void DAB::setFreq(uint8_t freq) {
   SPIbuffer[5] = 0x00;
   SPIwrite(SPIbuffer, 6);
   cts();
+}
 
-  uint16_t timeout = 250;
-  while (bitRead(SPIbuffer[1], 0) == false) {
-    delay(20);
-    memset(SPIbuffer, 0, 5);
-    SPIwrite(SPIbuffer, 5);
-    timeout--;
-    if (timeout == 0) {
-      break;
-    }
-  }
+bool DAB::tuneDone(void) {
+  memset(SPIbuffer, 0, 5);
+  SPIwrite(SPIbuffer, 5);
+  return bitRead(SPIbuffer[1], 0);
+}
 
+// DAB_DIGRAD_STATUS as the scanner needs it: VALID, ACQ and the fast detect count, STC acknowledged
+void DAB::getScanStatus(void) {
   SPIbuffer[0] = 0xB2;
   SPIbuffer[1] = 0x01;
   SPIwrite(SPIbuffer, 2);
   cts();
+  SPIread(24);
+  signalvalid = bitRead(SPIbuffer[6], 0);
+  acquired = bitRead(SPIbuffer[6], 2);
+  fic = SPIbuffer[9];
+  cnr = SPIbuffer[10];
+  fastdetect = SPIbuffer[24];
+  signallock = (fic > 0);
+}
+
+// Short validation windows while scanning, the values of DABProperties and the chip defaults otherwise
+void DAB::setScanTiming(bool scanning) {
+  Set_Property(0xB200, scanning ? SCAN_VALID_RSSI_TIME : 0x0000);  // DAB_VALID_RSSI_TIME
+  Set_Property(0xB202, scanning ? SCAN_VALID_ACQ_TIME : 2000);     // DAB_VALID_ACQ_TIME
+  Set_Property(0xB203, scanning ? SCAN_VALID_SYNC_TIME : 1200);    // DAB_VALID_SYNC_TIME
+}
+
+void DAB::standby(void) {
+  if (numberofservices > 0) {
+    SPIbuffer[0] = 0x82;  // STOP_DIGITAL_SERVICE
+    SPIbuffer[1] = 0x00;
+    SPIbuffer[2] = 0x00;
+    SPIbuffer[3] = 0x00;
+    SPIbuffer[4] = service[ServiceIndex].ServiceID & 0xff;
+    SPIbuffer[5] = (service[ServiceIndex].ServiceID >> 8) & 0xff;
+    SPIbuffer[6] = (service[ServiceIndex].ServiceID >> 16) & 0xff;
+    SPIbuffer[7] = (service[ServiceIndex].ServiceID >> 24) & 0xff;
+    SPIbuffer[8] = service[ServiceIndex].CompID & 0xff;
+    SPIbuffer[9] = (service[ServiceIndex].CompID >> 8) & 0xff;
+    SPIbuffer[10] = (service[ServiceIndex].CompID >> 16) & 0xff;
+    SPIbuffer[11] = (service[ServiceIndex].CompID >> 24) & 0xff;
+    SPIwrite(SPIbuffer, 12);
+    cts();
+  }
+
+  Set_Property(0x0301, 0x0003);  // Mute both channels
+  warmStart = WARM_START_MAGIC;
 }
 
 void DAB::setService(uint8_t _index) {
@@ -981,6 +1488,7 @@ void DAB::setService(uint8_t _index) {
   bitrate = 0;
   protectionlevel = 0;
   for (byte x = 0; x < 128; x++) ServiceData[x] = '\0';
+  clearDLPlus();
   SlideShowByteCounter = 0;
   SlideShowLength = 0;
   SlideShowLengthOld = 0;
@@ -989,6 +1497,10 @@ void DAB::setService(uint8_t _index) {
   SlideShowInit = false;
   ServiceStart = true;
   ServiceIndex = _index;
+  announcementSupport = 0;
+  announcementClusterCount = 0;
+  AnnouncementActive = false;
+  AnnouncementType = 0;
   ecc = 0;  // Reset so ServiceInfo() picks up the new service's ECC
   serviceHasOwnEcc = false;
 
@@ -1063,79 +1575,146 @@ void DAB::RecoverSlideShow(void) {
 }
 
 void DAB::Update(void) {
+  // Service data always goes first, the chip only buffers a few packets
   if (signallock) {
     getServiceData();
   }
 
-  if (millis() - DataUpdate > 500 || !signallock) {
-    EnsembleInfo();
+  // FIG 0/19 stops repeating when the FIC is lost, do not stay on the announcement forever
+  if (AnnouncementActive && millis() - announcementSeen > ANNOUNCEMENT_TIMEOUT) endAnnouncement();
 
-    if (signallock) {
-      ServiceInfo();
-    }
-    if (ServiceStart) RecoverSlideShow();
-
-    if (ServiceStart) {
-      for (int i = 0; i < numberofservices; i++) {
-        if (service[i].ServiceType == 3 && strstr(service[i].Label, "tpeg") == NULL && strstr(service[i].Label, "TPEG") == NULL) {
-          if (service[i].CompID != dataServiceCheck) {
-            SPIbuffer[0] = 0x81;
-            SPIbuffer[1] = 0x01;
-            SPIbuffer[2] = 0x00;
-            SPIbuffer[3] = 0x00;
-            SPIbuffer[4] = service[i].ServiceID & 0xff;
-            SPIbuffer[5] = (service[i].ServiceID >> 8) & 0xff;
-            SPIbuffer[6] = (service[i].ServiceID >> 16) & 0xff;
-            SPIbuffer[7] = (service[i].ServiceID >> 24) & 0xff;
-            SPIbuffer[8] = service[i].CompID & 0xff;
-            SPIbuffer[9] = (service[i].CompID >> 8) & 0xff;
-            SPIbuffer[10] = (service[i].CompID >> 16) & 0xff;
-            SPIbuffer[11] = (service[i].CompID >> 24) & 0xff;
-            SPIwrite(SPIbuffer, 12);
-            dataServiceCheck = service[i].CompID;
-            break;
-          }
-        }
-      }
-    }
-    DataUpdate = millis();
+  // Then whatever queries are due
+  runJobs(JOBS_ALL);
+}
+
+// Update() for a scan waiting on an ensemble: no service data, slideshows or EPG, so no LittleFS work either
+void DAB::ScanUpdate(void) {
+  runJobs(JOBS_SCAN);
+
+  // A scan waits for every service type, so fetch them back-to-back instead of one per period
+  unsigned long start = micros();
+  while (signallock && micros() - start < UPDATE_BUDGET) {
+    uint8_t known = components;
+    ComponentInfo();
+    if (components == known) break;
   }
 }
 
-String DAB::ASCII(const char* input, uint8_t charset) {
-  if (!input) return String();
-  String result;
-  if (charset != 0) return String(input);
+// Due jobs out of the mask, in priority order, until the budget is spent
+void DAB::runJobs(uint8_t jobs) {
+  unsigned long start = micros();
+  for (uint8_t job = 0; job < RADIO_JOBS; job++) {
+    if (!bitRead(jobs, job) || (long)(millis() - jobDue[job]) < 0) continue;
+    runJob(job);
+    jobDue[job] = millis() + ((job == JOB_SIGNAL && !signallock) ? JOB_SIGNAL_SEARCH : jobPeriod[job]);
+    if (micros() - start > UPDATE_BUDGET) break;
+  }
+}
 
-  bool looksLikeUTF8 = false;
-  for (size_t i = 0; input[i] != '\0'; i++) {
-    uint8_t c = (uint8_t)input[i];
+void DAB::runJob(uint8_t job) {
+  switch (job) {
+    case JOB_SIGNAL: getSignalStatus(); break;
+    case JOB_RSSI: rssi = getRSSI(); break;
+    case JOB_ENSEMBLE: EnsembleInfo(); break;
+    case JOB_SERVICE: if (signallock) ServiceInfo(); break;
+    case JOB_DATA: if (ServiceStart) RecoverSlideShow(); startDataServices(); break;
+    case JOB_COMPONENTS: if (signallock) ComponentInfo(); break;
+    case JOB_TIME: if (signallock) getTime(); break;
+    case JOB_PANIC: crashed = panic(); break;
+  }
+}
 
-    if ((c & 0xE0) == 0xC0) {
-      uint8_t c2 = (uint8_t)input[i + 1];
-      if ((c2 & 0xC0) == 0x80) {
-        looksLikeUTF8 = true;
-        break;
+void DAB::startDataServices(void) {
+  if (ServiceStart) {
+    for (int i = 0; i < numberofcomponents; i++) {
+      int16_t owner = findService(component[i].ServiceID);
+      const char* label = (owner < 0) ? "" : service[owner].Label;
+      if (component[i].ServiceType == 3 && strstr(label, "tpeg") == NULL && strstr(label, "TPEG") == NULL) {
+        if (component[i].CompID != dataServiceCheck) {
+          SPIbuffer[0] = 0x81;
+          SPIbuffer[1] = 0x01;
+          SPIbuffer[2] = 0x00;
+          SPIbuffer[3] = 0x00;
+          SPIbuffer[4] = component[i].ServiceID & 0xff;
+          SPIbuffer[5] = (component[i].ServiceID >> 8) & 0xff;
+          SPIbuffer[6] = (component[i].ServiceID >> 16) & 0xff;
+          SPIbuffer[7] = (component[i].ServiceID >> 24) & 0xff;
+          SPIbuffer[8] = component[i].CompID & 0xff;
+          SPIbuffer[9] = (component[i].CompID >> 8) & 0xff;
+          SPIbuffer[10] = (component[i].CompID >> 16) & 0xff;
+          SPIbuffer[11] = (component[i].CompID >> 24) & 0xff;
+          SPIwrite(SPIbuffer, 12);
+          dataServiceCheck = component[i].CompID;
+          break;
+        }
       }
-    } else if ((c & 0xF0) == 0xE0) {
-      uint8_t c2 = (uint8_t)input[i + 1];
-      uint8_t c3 = (uint8_t)input[i + 2];
-      if ((c2 & 0xC0) == 0x80 && (c3 & 0xC0) == 0x80) {
-        looksLikeUTF8 = true;
+    }
+  }
+
+  if ((FICStream || FICDecode) && FICServiceCheck == 0) {
+    for (int i = 0; i < numberofcomponents; i++) {
+      if (component[i].ServiceType == 6) {
+        SPIbuffer[0] = 0x81;
+        SPIbuffer[1] = 0x01;
+        SPIbuffer[2] = 0x00;
+        SPIbuffer[3] = 0x00;
+        SPIbuffer[4] = component[i].ServiceID & 0xff;
+        SPIbuffer[5] = (component[i].ServiceID >> 8) & 0xff;
+        SPIbuffer[6] = (component[i].ServiceID >> 16) & 0xff;
+        SPIbuffer[7] = (component[i].ServiceID >> 24) & 0xff;
+        SPIbuffer[8] = component[i].CompID & 0xff;
+        SPIbuffer[9] = (component[i].CompID >> 8) & 0xff;
+        SPIbuffer[10] = (component[i].CompID >> 16) & 0xff;
+        SPIbuffer[11] = (component[i].CompID >> 24) & 0xff;
+        SPIwrite(SPIbuffer, 12);
+        FICServiceCheck = component[i].CompID;
         break;
       }
     }
   }
+}
+
+// Converted once per distinct raw label, the display and serial reports ask for the same few labels every loop
+const char* DAB::label(const char* input, uint8_t charset, size_t size) {
+  size_t length = min(charsetLength(input, charset, size), sizeof(textRaw[0]));
+  if (length == 0) return "";
 
-  if (looksLikeUTF8) {
-    return String(input);
+  uint32_t hash = 2166136261UL ^ charset;
+  for (size_t i = 0; i < length; i++) hash = (hash ^ (uint8_t)input[i]) * 16777619UL;
+
+  if (length < sizeof(labelRaw[0])) {
+    for (uint8_t x = 0; x < LABEL_CACHE_SIZE; x++) {
+      if (labelHash[x] == hash && labelCharset[x] == charset && labelLength[x] == length && memcmp(labelRaw[x], input, length) == 0) return labelText[x];
+    }
+    uint8_t x = labelNext;
+    labelNext = (labelNext + 1) % LABEL_CACHE_SIZE;
+    labelHash[x] = hash;
+    labelCharset[x] = charset;
+    labelLength[x] = length;
+    memcpy(labelRaw[x], input, length);
+    charsetConvert(input, length, charset, labelText[x], sizeof(labelText[x]));
+    LabelConversions++;
+    return labelText[x];
   }
 
-  wchar_t temp[128];
-  charConverter(input, temp, sizeof(temp) / sizeof(wchar_t));
-  result = convertToUTF8(temp);
+  for (uint8_t x = 0; x < TEXT_CACHE_SIZE; x++) {
+    if (textHash[x] == hash && textCharset[x] == charset && textLength[x] == length && memcmp(textRaw[x], input, length) == 0) return textText[x];
+  }
+  uint8_t x = textNext;
+  textNext = (textNext + 1) % TEXT_CACHE_SIZE;
+  textHash[x] = hash;
+  textCharset[x] = charset;
+  textLength[x] = length;
+  memcpy(textRaw[x], input, length);
+  charsetConvert(input, length, charset, textText[x], sizeof(textText[x]));
+  LabelConversions++;
+  return textText[x];
+}
 
-  return result;
+String DAB::ASCII(const char* input, uint8_t charset, size_t size) {
+  char text[TEXT_TEXT_SIZE];
+  charsetConvert(input, charsetLength(input, charset, size), charset, text, sizeof(text));
+  return String(text);
 }
 
 
@@ -1148,224 +1727,100 @@ static int compareCompID(const void* a, const void* b) {
   return 0;
 }
 
-static void charConverter(const char* input, wchar_t* output, size_t outSize) {
-    if (!input || !output || outSize == 0) return;
-
-    size_t i = 0;
-
-    for (size_t dbi = 0; input[dbi] != '\0' && i < outSize - 1; dbi++) {
-        uint8_t currentChar = (uint8_t)input[dbi];
-
-        // ----- 2-byte UTF-8 decoding -----
-        if ((currentChar & 0xE0) == 0xC0) {
-            uint8_t nextChar = (uint8_t)input[dbi + 1];
+static int8_t findComponent(uint32_t serviceID, uint32_t compID) {
+  for (uint8_t i = 0; i < components; i++) {
+    if (componentService[i] == serviceID && componentComp[i] == compID) return i;
+  }
+  return -1;
+}
 
-            if ((nextChar & 0xC0) == 0x80) {
-                // decode the Unicode code point
-                uint16_t codepoint = ((currentChar & 0x1F) << 6) | (nextChar & 0x3F);
-                output[i++] = (wchar_t)codepoint;
-                dbi++; // skip the second byte
-                continue;
-            }
-        }
+static uint16_t crc16(const uint8_t* data, uint16_t length) {
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  }
+  return ~crc;
+}
 
-        // ----- Single-byte / fallback -----
-        switch (currentChar) {
-            case 0x20: output[i] = L' '; break;
-            case 0x21 ... 0x5D: output[i] = (wchar_t)currentChar; break;
-            case 0x5E: output[i] = L'―'; break;
-            case 0x5F: output[i] = L'_'; break;
-            case 0x60: output[i] = L'`'; break;
-            case 0x61 ... 0x7D: output[i] = (wchar_t)currentChar; break;
-            case 0x7E: output[i] = L'¯'; break;
-            case 0x7F: output[i] = L' '; break;
-            case 0x80: output[i] = L'á'; break;
-            case 0x81: output[i] = L'à'; break;
-            case 0x82: output[i] = L'é'; break;
-            case 0x83: output[i] = L'è'; break;
-            case 0x84: output[i] = L'í'; break;
-            case 0x85: output[i] = L'ì'; break;
-            case 0x86: output[i] = L'ó'; break;
-            case 0x87: output[i] = L'ò'; break;
-            case 0x88: output[i] = L'ú'; break;
-            case 0x89: output[i] = L'ù'; break;
-            case 0x8A: output[i] = L'Ñ'; break;
-            case 0x8B: output[i] = L'Ç'; break;
-            case 0x8C: output[i] = L'Ş'; break;
-            case 0x8D: output[i] = L'β'; break;
-            case 0x8E: output[i] = L'¡'; break;
-            case 0x8F: output[i] = L'Ĳ'; break;
-            case 0x90: output[i] = L'â'; break;
-            case 0x91: output[i] = L'ä'; break;
-            case 0x92: output[i] = L'ê'; break;
-            case 0x93: output[i] = L'ë'; break;
-            case 0x94: output[i] = L'î'; break;
-            case 0x95: output[i] = L'ï'; break;
-            case 0x96: output[i] = L'ô'; break;
-            case 0x97: output[i] = L'ö'; break;
-            case 0x98: output[i] = L'û'; break;
-            case 0x99: output[i] = L'ü'; break;
-            case 0x9A: output[i] = L'ñ'; break;
-            case 0x9B: output[i] = L'ç'; break;
-            case 0x9C: output[i] = L'ş'; break;
-            case 0x9D: output[i] = L'ǧ'; break;
-            case 0x9E: output[i] = L'ı'; break;
-            case 0x9F: output[i] = L'ĳ'; break;
-            case 0xA0: output[i] = L'Ķ'; break;
-            case 0xA1: output[i] = L'Ņ'; break;
-            case 0xA2: output[i] = L'©'; break;
-            case 0xA3: output[i] = L'Ģ'; break;
-            case 0xA4: output[i] = L'Ğ'; break;
-            case 0xA5: output[i] = L'ě'; break;
-            case 0xA6: output[i] = L'ň'; break;
-            case 0xA7: output[i] = L'ő'; break;
-            case 0xA8: output[i] = L'Ő'; break;
-            case 0xA9: output[i] = L'€'; break;
-            case 0xAA: output[i] = L'£'; break;
-            case 0xAB: output[i] = L'$'; break;
-            case 0xAC: output[i] = L'Ā'; break;
-            case 0xAD: output[i] = L'Ē'; break;
-            case 0xAE: output[i] = L'Ī'; break;
-            case 0xAF: output[i] = L'Ū'; break;
-            case 0xB0: output[i] = L'ķ'; break;
-            case 0xB1: output[i] = L'ņ'; break;
-            case 0xB2: output[i] = L'ļ'; break;
-            case 0xB3: output[i] = L'ģ'; break;
-            case 0xB4: output[i] = L'ľ'; break;
-            case 0xB5: output[i] = L'İ'; break;
-            case 0xB6: output[i] = L'ń'; break;
-            case 0xB7: output[i] = L'ű'; break;
-            case 0xB8: output[i] = L'Ű'; break;
-            case 0xB9: output[i] = L'¿'; break;
-            case 0xBA: output[i] = L'ľ'; break;
-            case 0xBB: output[i] = L'°'; break;
-            case 0xBC: output[i] = L'ā'; break;
-            case 0xBD: output[i] = L'ē'; break;
-            case 0xBE: output[i] = L'ī'; break;
-            case 0xBF: output[i] = L'ū'; break;
-            case 0xC0: output[i] = L'Á'; break;
-            case 0xC1: output[i] = L'À'; break;
-            case 0xC2: output[i] = L'É'; break;
-            case 0xC3: output[i] = L'È'; break;
-            case 0xC4: output[i] = L'Í'; break;
-            case 0xC5: output[i] = L'Ì'; break;
-            case 0xC6: output[i] = L'Ó'; break;
-            case 0xC7: output[i] = L'Ò'; break;
-            case 0xC8: output[i] = L'Ú'; break;
-            case 0xC9: output[i] = L'Ù'; break;
-            case 0xCA: output[i] = L'Ř'; break;
-            case 0xCB: output[i] = L'Č'; break;
-            case 0xCC: output[i] = L'Š'; break;
-            case 0xCD: output[i] = L'Ž'; break;
-            case 0xCE: output[i] = L'Ð'; break;
-            case 0xCF: output[i] = L'Ŀ'; break;
-            case 0xD0: output[i] = L'Â'; break;
-            case 0xD1: output[i] = L'Ä'; break;
-            case 0xD2: output[i] = L'Ê'; break;
-            case 0xD3: output[i] = L'Ë'; break;
-            case 0xD4: output[i] = L'Î'; break;
-            case 0xD5: output[i] = L'Ï'; break;
-            case 0xD6: output[i] = L'Ô'; break;
-            case 0xD7: output[i] = L'Ö'; break;
-            case 0xD8: output[i] = L'Û'; break;
-            case 0xD9: output[i] = L'Ü'; break;
-            case 0xDA: output[i] = L'ř'; break;
-            case 0xDB: output[i] = L'č'; break;
-            case 0xDC: output[i] = L'š'; break;
-            case 0xDD: output[i] = L'ž'; break;
-            case 0xDE: output[i] = L'đ'; break;
-            case 0xDF: output[i] = L'ŀ'; break;
-            case 0xE0: output[i] = L'Ã'; break;
-            case 0xE1: output[i] = L'Å'; break;
-            case 0xE2: output[i] = L'Æ'; break;
-            case 0xE3: output[i] = L'Œ'; break;
-            case 0xE4: output[i] = L'ŷ'; break;
-            case 0xE5: output[i] = L'Ý'; break;
-            case 0xE6: output[i] = L'Õ'; break;
-            case 0xE7: output[i] = L'Ø'; break;
-            case 0xE8: output[i] = L'Þ'; break;
-            case 0xE9: output[i] = L'Ŋ'; break;
-            case 0xEA: output[i] = L'Ŕ'; break;
-            case 0xEB: output[i] = L'Ć'; break;
-            case 0xEC: output[i] = L'Ś'; break;
-            case 0xED: output[i] = L'Ź'; break;
-            case 0xEE: output[i] = L'Ť'; break;
-            case 0xEF: output[i] = L'ð'; break;
-            case 0xF0: output[i] = L'ã'; break;
-            case 0xF1: output[i] = L'å'; break;
-            case 0xF2: output[i] = L'æ'; break;
-            case 0xF3: output[i] = L'œ'; break;
-            case 0xF4: output[i] = L'ŵ'; break;
-            case 0xF5: output[i] = L'ý'; break;
-            case 0xF6: output[i] = L'õ'; break;
-            case 0xF7: output[i] = L'ø'; break;
-            case 0xF8: output[i] = L'þ'; break;
-            case 0xF9: output[i] = L'ŋ'; break;
-            case 0xFA: output[i] = L'ŕ'; break;
-            case 0xFB: output[i] = L'ć'; break;
-            case 0xFC: output[i] = L'ś'; break;
-            case 0xFD: output[i] = L'ź'; break;
-            case 0xFE: output[i] = L'ť'; break;
-            case 0xFF: output[i] = L' '; break;
-            default: output[i] = L'?'; break;
-        }
-        i++;
-    }
-    output[i] = L'\0';
-}
-
-static String extractUTF8Substring(const String& utf8String, size_t start, size_t length) {
-  String substring;
-  size_t utf8Length = utf8String.length();
-  size_t utf8Index = 0;
-  size_t charIndex = 0;
-
-  while (utf8Index < utf8Length && charIndex < start + length) {
-    uint8_t currentByte = utf8String.charAt(utf8Index);
-    uint8_t numBytes = 0;
-
-    if (currentByte < 0x80) {
-      numBytes = 1;
-    } else if ((currentByte >> 5) == 0x6) {
-      numBytes = 2;
-    } else if ((currentByte >> 4) == 0xE) {
-      numBytes = 3;
-    } else if ((currentByte >> 3) == 0x1E) {
-      numBytes = 4;
+// FIG 0/21: lists of (Id, R&M, frequencies), only DAB ensembles (R&M 0) are kept
+static void decodeFrequencyInformation(const uint8_t* data, uint8_t size) {
+  uint8_t offset = 0;
+  while (offset + 2 <= size) {
+    uint8_t end = offset + 2 + (data[offset + 1] & 0x1F);
+    if (end > size) return;
+    offset += 2;
+
+    while (offset + 3 <= end) {
+      uint16_t id = (data[offset] << 8) | data[offset + 1];
+      uint8_t rm = data[offset + 2] >> 4;
+      uint8_t length = data[offset + 2] & 0x07;
+      offset += 3;
+      if (offset + length > end) return;
+
+      for (uint8_t f = 0; rm == 0 && f + 3 <= length; f += 3) {
+        uint32_t frequency = (((uint32_t)(data[offset + f] & 0x07) << 16) | (data[offset + f + 1] << 8) | data[offset + f + 2]) * 16;
+        int8_t channel = channelFromFrequency(frequency);
+        if (channel < 0) continue;
+
+        bool known = false;
+        for (uint8_t i = 0; i < afCount; i++) if (afEId[i] == id && afChannel[i] == channel) known = true;
+        if (known) continue;
+        afEId[afNext] = id;
+        afChannel[afNext] = channel;
+        afNext = (afNext + 1) % AF_TABLE_SIZE;
+        if (afCount < AF_TABLE_SIZE) afCount++;
+      }
+      offset += length;
     }
+    offset = end;
+  }
+}
 
-    if (charIndex >= start) {
-      substring += utf8String.substring(utf8Index, utf8Index + numBytes);
+// FIG 0/24: per service, the other ensembles that carry it
+static void decodeOtherEnsembles(const uint8_t* data, uint8_t size, bool pd) {
+  uint8_t sidLength = pd ? 4 : 2;
+  uint8_t offset = 0;
+  while (offset + sidLength + 1 <= size) {
+    uint32_t sid = 0;
+    for (uint8_t i = 0; i < sidLength; i++) sid = (sid << 8) | data[offset + i];
+    offset += sidLength;
+    uint8_t count = data[offset] & 0x0F;
+    offset++;
+
+    for (uint8_t e = 0; e < count && offset + 2 <= size; e++, offset += 2) {
+      uint16_t eid = (data[offset] << 8) | data[offset + 1];
+      bool known = false;
+      for (uint8_t i = 0; i < oeCount; i++) if (oeSId[i] == sid && oeEId[i] == eid) known = true;
+      if (known) continue;
+      oeSId[oeNext] = sid;
+      oeEId[oeNext] = eid;
+      oeNext = (oeNext + 1) % OE_TABLE_SIZE;
+      if (oeCount < OE_TABLE_SIZE) oeCount++;
     }
-
-    utf8Index += numBytes;
-    charIndex++;
   }
-
-  return substring;
 }
 
-static String convertToUTF8(const wchar_t* input) {
-  String output;
-  while (*input) {
-    uint32_t unicode = *input;
-    if (unicode < 0x80) {
-      output += (char)unicode;
-    } else if (unicode < 0x800) {
-      output += (char)(0xC0 | (unicode >> 6));
-      output += (char)(0x80 | (unicode & 0x3F));
-    } else if (unicode < 0x10000) {
-      output += (char)(0xE0 | (unicode >> 12));
-      output += (char)(0x80 | ((unicode >> 6) & 0x3F));
-      output += (char)(0x80 | (unicode & 0x3F));
-    } else {
-      output += (char)(0xF0 | (unicode >> 18));
-      output += (char)(0x80 | ((unicode >> 12) & 0x3F));
-      output += (char)(0x80 | ((unicode >> 6) & 0x3F));
-      output += (char)(0x80 | (unicode & 0x3F));
-    }
-    input++;
+static int8_t channelFromFrequency(uint32_t frequency) {
+  for (uint8_t i = 0; i < sizeof(DABfrequencyTable_DAB) / sizeof(DABFrequencyLabel_DAB); i++) {
+    if (DABfrequencyTable_DAB[i].frequency == frequency) return i;
   }
-  return output;
+  return -1;
+}
 
+static void startDigitalService(uint32_t serviceID, uint32_t compID) {
+  SPIbuffer[0] = 0x81;
+  SPIbuffer[1] = 0x00;
+  SPIbuffer[2] = 0x00;
+  SPIbuffer[3] = 0x00;
+  SPIbuffer[4] = serviceID & 0xff;
+  SPIbuffer[5] = (serviceID >> 8) & 0xff;
+  SPIbuffer[6] = (serviceID >> 16) & 0xff;
+  SPIbuffer[7] = (serviceID >> 24) & 0xff;
+  SPIbuffer[8] = compID & 0xff;
+  SPIbuffer[9] = (compID >> 8) & 0xff;
+  SPIbuffer[10] = (compID >> 16) & 0xff;
+  SPIbuffer[11] = (compID >> 24) & 0xff;
+  SPIwrite(SPIbuffer, 12);
+  cts();
 }
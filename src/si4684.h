@@ -5,10 +5,55 @@
 #include <LittleFS.h>
 #include "Si468xROM.h"
 #include "firmware.h"
-#include <SPI.h>
+#include "si468xbus.h"
 #include <cstring>
 #include <climits>
 
+#define FIG_CACHE_SIZE  128   // Hash slots for FIG repetition suppression
+#define FIG_QUEUE_SIZE  1024  // Bytes of filtered FIGs waiting for the host
+#define AF_TABLE_SIZE   24    // (EId, channel) pairs from FIG 0/21
+#define OE_TABLE_SIZE   32    // (SId, EId) pairs from FIG 0/24
+#define ANNOUNCEMENT_CLUSTERS 8     // Clusters kept for the running service from FIG 0/18
+#define ANNOUNCEMENT_TIMEOUT  5000  // ms without FIG 0/19 before an announcement counts as over
+#define ANNOUNCEMENT_DEFAULT  0x0003  // Alarm and road traffic flash
+#define WARM_START_MAGIC 0x5734  // Marks a clean standby in RTC memory
+#define HOST_LOAD_SIZE  4092  // Image bytes per HOST_LOAD, the chip takes 4096 including the header
+#define PROPERTY_CACHE_SIZE 24  // Properties shadowed by the driver to skip redundant writes
+#define MAX_SERVICES    64    // Services kept from the ensemble list
+#define MAX_COMPONENTS  96    // Components of those services, primary and secondary
+#define COMPONENT_CACHE_SIZE MAX_COMPONENTS  // (ServiceID, CompID) pairs with a known service type
+#define SERVICE_DATA_BUDGET 8  // Service data packets drained per Update()
+#define UPDATE_BUDGET   3000  // us of scheduled radio queries per Update(), service data not included
+#define SCAN_VALID_RSSI_TIME  15   // ms, DAB_VALID_RSSI_TIME while scanning
+#define SCAN_VALID_ACQ_TIME   800  // ms, DAB_VALID_ACQ_TIME while scanning
+#define SCAN_VALID_SYNC_TIME  600  // ms, DAB_VALID_SYNC_TIME while scanning
+
+// Radio queries run by Update(), in priority order
+#define JOB_SIGNAL      0
+#define JOB_RSSI        1
+#define JOB_ENSEMBLE    2
+#define JOB_SERVICE     3
+#define JOB_DATA        4
+#define JOB_COMPONENTS  5
+#define JOB_TIME        6
+#define JOB_PANIC       7
+#define RADIO_JOBS      8
+#define JOBS_ALL        0xFF
+#define JOBS_SCAN       ((1 << JOB_SIGNAL) | (1 << JOB_ENSEMBLE) | (1 << JOB_SERVICE) | (1 << JOB_COMPONENTS) | (1 << JOB_PANIC))  // Just the ensemble and list
+#define JOB_SIGNAL_SEARCH 50  // ms between signal polls while there is no lock
+#define LABEL_CACHE_SIZE  80  // Converted labels up to 16 characters, a full service list plus the display
+#define LABEL_TEXT_SIZE   49  // 16 characters as UTF-8
+#define TEXT_CACHE_SIZE   2   // Converted radiotext sized strings
+#define TEXT_TEXT_SIZE    385 // 127 characters as UTF-8
+
+// DL Plus (ETSI TS 102 980) content types published as now playing fields
+#define DLPLUS_TAGS     4     // Tags one DL Plus command can carry
+#define DLPLUS_TITLE    0
+#define DLPLUS_ARTIST   1
+#define DLPLUS_ALBUM    2
+#define DLPLUS_PROGRAMME  3
+#define DLPLUS_FIELDS   4
+
 struct DABFrequencyLabel_DAB {
   uint32_t frequency;
   const char* label;
@@ -28,6 +73,14 @@ const DABFrequencyLabel_DAB DABfrequencyTable_DAB[] = {
 };
 
 
+// Properties written after boot: {property, value}
+static const uint16_t DABProperties[][2] = {
+  {0x0200, 0x8000}, {0x0202, 0x1600}, {0x0800, 0x0003}, {0x1710, 0xFC4A},
+  {0x1711, 0x00F8}, {0x8100, 0x0001}, {0x8101, 0x0064}, {0xB200, 0x0000},
+  {0xB201, 0x0080}, {0xB301, 0x0000}, {0xB302, 0x0000}, {0xB303, 0x0000},
+  {0xB400, 0x0097}, {0xB401, 0x0002}, {0xB500, 0x0000}
+};
+
 static const char* const ProtectionText[] {
   "",
   "UEP-1",
@@ -72,13 +125,33 @@ typedef struct _Services {
   byte    ServiceType;
 } DABService;
 
+// Span of ServiceData a DL Plus tag points at, Length 0 when the field is not tagged
+typedef struct _DLPlusView {
+  uint8_t   Start;
+  uint8_t   Length;
+} DLPlusView;
+
+typedef struct _Components {
+  uint32_t  ServiceID;
+  uint32_t  CompID;
+  byte    ServiceType;
+} DABComponent;
+
 class DAB {
   public:
-    bool begin(uint8_t SSpin);
+    bool begin(uint8_t SSpin, int8_t INTpin = -1, bool warm = false);
+    Si468xBus* getBus(void);
+    void setBus(Si468xBus* bus);
     bool BufferSlideShow;
+    bool crashed;
+    bool FICStream;
     bool panic(void);
     bool ServiceStart;
     bool signallock;
+    bool signalvalid;
+    bool acquired;
+    uint8_t fastdetect;
+    bool WarmStart;
     bool SlideShowAvailable;
     bool SlideShowDebug;
     bool SlideShowUpdate;
@@ -87,20 +160,54 @@ class DAB {
     char EnsembleLabel[17];
     char PStext[17];
     char ServiceData[128];
+    DLPlusView DLPlus[DLPLUS_FIELDS];  // Views into ServiceData, item fields only while the item runs
+    bool DLPlusItemRunning;
+    uint16_t DLPlusGeneration;          // Bumped whenever a field or the running state changes
+    const char* DLPlusText(const char* text, const DLPlusView& view, uint8_t charset);  // UI task only, like label()
     char SID[5];
     char* getChipID(void);
     char* getFirmwareVersion(void);
     const char* getChannel(uint8_t freq);
-    DABService service[32];
-    String ASCII(const char* input, uint8_t charset);
+    DABService service[MAX_SERVICES];
+    DABComponent component[MAX_COMPONENTS];
+    int16_t findService(uint32_t ServiceID);
+    void setCachedList(uint16_t version);
+    bool getComponentsKnown(void);
+    String ASCII(const char* input, uint8_t charset, size_t size = sizeof(DABService::Label));
+    const char* label(const char* input, uint8_t charset, size_t size = sizeof(DABService::Label));  // UI task only, valid until evicted by other labels
+    uint32_t LabelConversions;
+    int16_t rssi;
     uint16_t bitrate;
     uint16_t ecc;
     uint16_t ensembleEcc;
     bool serviceHasOwnEcc;
     uint16_t getRSSI(void);
+    uint32_t getRedundantWrites(void);
+    uint16_t getFIG(uint8_t* buffer, uint16_t size);
+    uint8_t getAlternatives(uint32_t ServiceID, uint8_t* channels, uint8_t size);
+    bool FICDecode;             // Keep the FIC flowing for the driver's own FIG decoding
+    uint16_t AnnouncementMask;  // ASw flag bits that may interrupt the running service, 0 for none
+    bool AnnouncementActive;
+    uint16_t AnnouncementType;  // ASw flags of the announcement being heard
+    uint16_t Announcements;
+    unsigned long AnnouncementLatency;  // us from the FIG 0/19 to the chip accepting the switch
+    void endAnnouncement(void);
     uint16_t samplerate;
+    uint16_t ServiceListVersion;
+    uint16_t ComponentGeneration;  // Bumped when ComponentInfo() fills in a service type
+    bool ServiceListCached;     // service[] came from the multiplex database, not yet from the chip
+    bool EnsembleCached;        // EID/EnsembleLabel came from the multiplex database, not yet from the chip
+    uint32_t ServiceListSkips;
     uint16_t Year;
+    uint32_t BootTime;
+    uint32_t LoadTime;
+    uint32_t FIG0ExtMask;
+    uint32_t FIGDuplicates;
+    uint32_t FIGForwarded;
     uint32_t getFreq(uint8_t freq);
+    uint32_t ServiceDataDeferred;
+    uint32_t ServiceDataDropped;
+    uint32_t ServiceDataOverflows;
     uint32_t SlideShowLength;
     uint8_t audiomode;
     uint8_t cnr;
@@ -108,10 +215,12 @@ class DAB {
     uint8_t EnsembleLabelCharset;
     uint8_t fic;
     uint8_t getFIC(void);
+    uint8_t FIGTypeMask;
     uint8_t Hours;
     uint8_t Minutes;
     uint8_t Months;
     uint8_t numberofservices = 0;
+    uint8_t numberofcomponents = 0;
     uint8_t protectionlevel;
     uint8_t pty;
     uint8_t Seconds;
@@ -121,10 +230,18 @@ class DAB {
     void clearData(void);
     void EnsembleInfo(void);
     void getServiceData(void);
+    void getSignalStatus(void);
+    void getTime(void);
     void ServiceInfo(void);
     void setFreq(uint8_t freq_index);
+    void tuneStart(uint8_t freq_index);
+    bool tuneDone(void);
+    void getScanStatus(void);
+    void setScanTiming(bool scanning);
     void setService(uint8_t index);
+    void standby(void);
     void Update(void);
+    void ScanUpdate(void);
     void vol(uint8_t vol);
 
   private:
@@ -139,6 +256,7 @@ class DAB {
     uint32_t componentID;
     uint32_t CurrentServiceID;
     uint32_t dataServiceCheck;
+    uint32_t FICServiceCheck;
     uint32_t serviceID;
     uint32_t SlideShowByteCounter;
     uint32_t SlideShowLengthOld;
@@ -151,7 +269,20 @@ class DAB {
     void assembleSlideshow(void);
     bool allSegmentsReceived(void);
 
-    void parseEPG(void);
+    void ComponentInfo(void);
+    void readServiceData(void);
+    void runJob(uint8_t job);
+    void runJobs(uint8_t jobs);
+    void startDataServices(void);
+    void parseEPG(const uint8_t* data, uint16_t length, uint8_t segment, uint16_t transportID);
+    void parseDLPlus(const uint8_t* data);
+    void applyDLPlus(void);
+    void clearDLPlus(void);
+    void parseFIB(const uint8_t* fib);
+    void parseFIG(const uint8_t* fig, uint8_t length);
+    void decodeFIG(const uint8_t* fig, uint8_t length);
+    void decodeAnnouncementSupport(const uint8_t* data, uint8_t size);
+    void decodeAnnouncementSwitching(const uint8_t* data, uint8_t size);
     void RecoverSlideShow(void);
 };
 
@@ -0,0 +1,233 @@
+#include "si468xbus.h"
+
+void Si468xSPI::begin(uint8_t SSpin) {
+  slaveSelectPin = SSpin;
+  pinMode(slaveSelectPin, OUTPUT);  // Configure SPI
+  digitalWrite(slaveSelectPin, HIGH);
+  SPI.begin(14, 16, 13, SSpin);
+}
+
+void Si468xSPI::transfer(uint8_t* data, uint32_t length) {
+  SPI.beginTransaction(SPISettings(SI468X_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+  digitalWrite(slaveSelectPin, LOW);
+  SPI.transfer(data, length);
+  digitalWrite(slaveSelectPin, HIGH);
+  SPI.endTransaction();
+}
+
+void Si468xSPI::write(const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint32_t length) {
+  SPI.beginTransaction(SPISettings(SI468X_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+  digitalWrite(slaveSelectPin, LOW);
+  SPI.writeBytes(header, headerLength);
+  SPI.writeBytes(data, length);
+  digitalWrite(slaveSelectPin, HIGH);
+  SPI.endTransaction();
+}
+
+bool Si468xRecorder::start(Si468xBus* target, const char* filename) {
+  if (trace) trace.close();
+  bus = target;
+  traceBytes = 0;
+  traceFull = false;
+  trace = LittleFS.open(filename, "wb");
+  return trace;
+}
+
+void Si468xRecorder::stop(void) {
+  if (trace) trace.close();
+}
+
+Si468xBus* Si468xRecorder::target(void) {
+  return bus;
+}
+
+bool Si468xRecorder::truncated(void) {
+  return traceFull;
+}
+
+void Si468xRecorder::begin(uint8_t SSpin) {
+  bus->begin(SSpin);
+}
+
+void Si468xRecorder::transfer(uint8_t* data, uint32_t length) {
+  // Reads start with RD_REPLY (0x00), log what came back. Anything else is a command, log what went out.
+  bool reply = (data[0] == 0x00);
+
+  if (!reply) record('W', data, length, NULL, 0);
+  bus->transfer(data, length);
+  if (reply && length > 5) record('R', data, length, NULL, 0);  // Status polls only repeat what the next reply says
+}
+
+void Si468xRecorder::write(const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint32_t length) {
+  record('W', header, headerLength, data, length);
+  bus->write(header, headerLength, data, length);
+}
+
+void Si468xRecorder::record(char type, const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint32_t length) {
+  uint32_t total = headerLength + length;
+  if (!trace || traceFull) return;
+  if (traceBytes + 3 + total > SI468X_TRACE_MAX) {
+    traceFull = true;
+    return;
+  }
+
+  uint8_t prefix[3] = {(uint8_t)type, (uint8_t)(total & 0xFF), (uint8_t)((total >> 8) & 0xFF)};
+  trace.write(prefix, sizeof(prefix));
+  trace.write(header, headerLength);
+  if (length > 0) trace.write(data, length);
+  traceBytes += 3 + total;
+}
+
+bool Si468xEmulator::load(const char* filename) {
+  if (trace) trace.close();
+  rules = 0;
+  replies = 0;
+  command = 0;
+  reply = SI468X_EMU_NONE;
+  channel = SI468X_EMU_ANY;
+  booted = false;
+  stc = false;
+  started = false;
+  trace = LittleFS.open(filename, "rb");
+  if (!trace) return false;
+
+  uint8_t pending[SI468X_EMU_MATCH];
+  uint8_t pendingLength = 0;
+  uint8_t pendingChannel = SI468X_EMU_ANY;
+  uint8_t context = SI468X_EMU_ANY;
+  uint32_t bestOffset = 0;
+  uint16_t bestLength = 0;
+  uint32_t bestHash = 0;
+  uint8_t header[3];
+
+  while (trace.read(header, sizeof(header)) == sizeof(header)) {
+    uint16_t recordLength = header[1] | (header[2] << 8);
+    uint32_t recordOffset = trace.position();
+
+    if (header[0] == 'W' && recordLength > 0) {
+      // The reply a command gets is the longest read after it, the shorter ones are the same bytes cut off
+      if (bestLength > 0) addReply(pending, pendingLength, pendingChannel, bestOffset, bestLength, bestHash);
+      bestLength = 0;
+
+      pendingLength = trace.read(pending, min((uint16_t)SI468X_EMU_MATCH, recordLength));
+      pendingChannel = (pending[0] == 0xB0) ? SI468X_EMU_ANY : context;
+      if (pending[0] == 0xB0 && pendingLength > 2) context = pending[2];
+    } else if (header[0] == 'R' && recordLength > 5 && recordLength > bestLength && pendingLength > 0) {
+      // FNV-1a over everything behind the status byte, so repeated replies take only one slot
+      uint32_t hash = 2166136261UL;
+      uint8_t chunk[64];
+      trace.seek(recordOffset + 2);
+      for (uint16_t done = 2; done < recordLength;) {
+        uint16_t size = trace.read(chunk, min((uint16_t)sizeof(chunk), (uint16_t)(recordLength - done)));
+        if (size == 0) break;
+        for (uint16_t i = 0; i < size; i++) hash = (hash ^ chunk[i]) * 16777619UL;
+        done += size;
+      }
+      bestOffset = recordOffset;
+      bestLength = recordLength;
+      bestHash = hash;
+    }
+    trace.seek(recordOffset + recordLength);
+  }
+  if (bestLength > 0) addReply(pending, pendingLength, pendingChannel, bestOffset, bestLength, bestHash);
+
+  for (uint8_t rule = 0; rule < rules; rule++) ruleCursor[rule] = ruleFirst[rule];
+  return true;
+}
+
+int16_t Si468xEmulator::findRule(const uint8_t* command, uint8_t length, uint8_t channel) {
+  for (uint8_t rule = 0; rule < rules; rule++) {
+    if (ruleChannel[rule] == channel && ruleLength[rule] == length && memcmp(ruleCommand[rule], command, length) == 0) return rule;
+  }
+  return -1;
+}
+
+void Si468xEmulator::addReply(const uint8_t* command, uint8_t length, uint8_t channel, uint32_t offset, uint16_t size, uint32_t hash) {
+  int16_t rule = findRule(command, length, channel);
+  if (rule < 0) {
+    if (rules == SI468X_EMU_RULES) return;
+    rule = rules++;
+    memcpy(ruleCommand[rule], command, length);
+    ruleLength[rule] = length;
+    ruleChannel[rule] = channel;
+    ruleFirst[rule] = SI468X_EMU_NONE;
+    ruleLast[rule] = SI468X_EMU_NONE;
+  } else if (ruleHash[rule] == hash && replyLength[ruleLast[rule]] == size) {
+    return;
+  }
+  if (replies == SI468X_EMU_REPLIES) return;
+
+  replyOffset[replies] = offset;
+  replyLength[replies] = size;
+  replyNext[replies] = SI468X_EMU_NONE;
+  if (ruleFirst[rule] == SI468X_EMU_NONE) ruleFirst[rule] = replies; else replyNext[ruleLast[rule]] = replies;
+  ruleLast[rule] = replies;
+  ruleHash[rule] = hash;
+  replies++;
+}
+
+bool Si468xEmulator::dataPending(void) {
+  static const uint8_t getServiceData[2] = {0x84, 0x01};
+  if (!started) return false;
+  int16_t rule = findRule(getServiceData, sizeof(getServiceData), channel);
+  if (rule < 0) rule = findRule(getServiceData, sizeof(getServiceData), SI468X_EMU_ANY);
+  return rule >= 0 && ruleCursor[rule] != SI468X_EMU_NONE;
+}
+
+void Si468xEmulator::begin(uint8_t SSpin) {
+}
+
+void Si468xEmulator::write(const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint32_t length) {
+  command = header[0];
+  reply = SI468X_EMU_NONE;
+}
+
+void Si468xEmulator::transfer(uint8_t* data, uint32_t length) {
+  if (data[0] != 0x00) {
+    command = data[0];
+    uint8_t matchLength = min(length, (uint32_t)SI468X_EMU_MATCH);
+
+    switch (command) {
+      case 0x01: booted = false; started = false; break;  // POWER_UP
+      case 0x07: booted = true; break;  // BOOT
+      case 0x81: started = true; break;  // START_DIGITAL_SERVICE
+      case 0x82: started = false; break;  // STOP_DIGITAL_SERVICE
+      case 0xB2: if (length > 1 && bitRead(data[1], 0)) stc = false; break;  // DAB_DIGRAD_STATUS with STC_ACK
+      case 0xB0:  // DAB_TUNE_FREQ, the new channel plays its script from the start
+        if (length > 2) channel = data[2];
+        stc = true;
+        started = false;
+        for (uint8_t rule = 0; rule < rules; rule++) {
+          if (ruleChannel[rule] == channel) ruleCursor[rule] = ruleFirst[rule];
+        }
+        break;
+    }
+
+    int16_t rule = findRule(data, matchLength, channel);
+    if (rule < 0) rule = findRule(data, matchLength, SI468X_EMU_ANY);
+    reply = SI468X_EMU_NONE;
+    if (rule >= 0 && ruleCursor[rule] != SI468X_EMU_NONE) {
+      reply = ruleCursor[rule];
+      if (replyNext[reply] != SI468X_EMU_NONE) ruleCursor[rule] = replyNext[reply];
+      else if (command == 0x84) ruleCursor[rule] = SI468X_EMU_NONE;  // Packets are used up, others keep their last state
+    }
+    return;
+  }
+
+  memset(data, 0, length);
+  if (reply != SI468X_EMU_NONE) {
+    trace.seek(replyOffset[reply]);
+    trace.read(data, min(length, (uint32_t)replyLength[reply]));
+  } else if (command == 0x09 && length > 5) {
+    data[5] = booted ? 2 : 0;  // GET_SYS_STATE, DAB image once booted
+  } else if (command == 0x08 && length > 10) {
+    data[9] = 4684 & 0xFF;  // GET_PART_INFO
+    data[10] = 4684 >> 8;
+  } else if (command == 0x12 && length > 7) {
+    data[5] = 6;  // GET_FUNC_INFO
+    data[6] = 0;
+    data[7] = 5;
+  }
+
+  if (length > 1) data[1] = 0x80 | (data[1] & 0x40) | (dataPending() ? 0x10 : 0x00) | (stc ? 0x01 : 0x00);
+}
@@ -0,0 +1,97 @@
+#ifndef si468xbus_h
+#define si468xbus_h
+
+#include "Arduino.h"
+#include <LittleFS.h>
+#include <SPI.h>
+
+#define SI468X_SPI_CLOCK      10000000       // Si468x SCLK maximum, also during the firmware upload
+#define SI468X_EMU_FILE       "/si468x.emu"  // Script that takes the place of the chip when present at boot
+#define SI468X_TRACE_MAX      131072         // Bytes a trace may take in LittleFS, recording stops there
+#define SI468X_TRACE_FILE     "/si468x.trc"  // Where Si468xRecorder writes the TRACE session
+#define SI468X_EMU_MATCH      12             // Command bytes that select an emulator reply
+#define SI468X_EMU_RULES      96             // Distinct (command, channel) pairs a script can answer
+#define SI468X_EMU_REPLIES    256            // Replies over all rules
+#define SI468X_EMU_ANY        0xFF           // Rule channel that answers on every channel
+#define SI468X_EMU_NONE       0xFFFF         // End of a reply chain
+
+// Transport between the DAB driver and the Si468x. Every transfer is full duplex and in place:
+// the bytes in data are clocked out and replaced by what the chip returned.
+class Si468xBus {
+  public:
+    virtual void begin(uint8_t SSpin) = 0;
+    virtual void transfer(uint8_t* data, uint32_t length) = 0;
+    // Write only, header and data go out in one chip select. Data may point straight into flash.
+    virtual void write(const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint32_t length) = 0;
+};
+
+class Si468xSPI : public Si468xBus {
+  public:
+    void begin(uint8_t SSpin);
+    void transfer(uint8_t* data, uint32_t length);
+    void write(const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint32_t length);
+
+  private:
+    uint8_t slaveSelectPin;
+};
+
+// Passes everything to another bus and logs it to a trace file.
+// Record format: one byte 'W' (command) or 'R' (reply), two bytes length LSB first, then the bytes.
+// Bare status polls are not logged and the trace stops growing at SI468X_TRACE_MAX.
+class Si468xRecorder : public Si468xBus {
+  public:
+    bool start(Si468xBus* target, const char* filename);
+    void stop(void);
+    Si468xBus* target(void);
+    bool truncated(void);
+    void begin(uint8_t SSpin);
+    void transfer(uint8_t* data, uint32_t length);
+    void write(const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint32_t length);
+
+  private:
+    void record(char type, const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint32_t length);
+    Si468xBus* bus;
+    File trace;
+    uint32_t traceBytes;
+    bool traceFull;
+};
+
+// Stands in for the chip, answering from a script in the recorder's format. Every 'W' with its
+// longest 'R' becomes a reply for that exact command on the channel last tuned before it; a
+// command that is scripted more than once answers with each reply in turn and then repeats the
+// last, service data (0x84) runs dry instead. The status byte is made up from what was sent:
+// CTS always, STCINT after a tune until acknowledged, DSRVINT while a started service has
+// packets left. GET_SYS_STATE, GET_PART_INFO and GET_FUNC_INFO work without a script.
+class Si468xEmulator : public Si468xBus {
+  public:
+    bool load(const char* filename);
+    void begin(uint8_t SSpin);
+    void transfer(uint8_t* data, uint32_t length);
+    void write(const uint8_t* header, uint8_t headerLength, const uint8_t* data, uint32_t length);
+
+  private:
+    int16_t findRule(const uint8_t* command, uint8_t length, uint8_t channel);
+    void addReply(const uint8_t* command, uint8_t length, uint8_t channel, uint32_t offset, uint16_t size, uint32_t hash);
+    bool dataPending(void);
+    uint8_t ruleCommand[SI468X_EMU_RULES][SI468X_EMU_MATCH];
+    uint8_t ruleLength[SI468X_EMU_RULES];
+    uint8_t ruleChannel[SI468X_EMU_RULES];
+    uint16_t ruleFirst[SI468X_EMU_RULES];
+    uint16_t ruleLast[SI468X_EMU_RULES];
+    uint16_t ruleCursor[SI468X_EMU_RULES];
+    uint32_t ruleHash[SI468X_EMU_RULES];
+    uint8_t rules;
+    uint32_t replyOffset[SI468X_EMU_REPLIES];
+    uint16_t replyLength[SI468X_EMU_REPLIES];
+    uint16_t replyNext[SI468X_EMU_REPLIES];
+    uint16_t replies;
+    uint8_t command;
+    uint16_t reply;
+    uint8_t channel;
+    bool booted;
+    bool stc;
+    bool started;
+    File trace;
+};
+
+#endif
@@ -0,0 +1,41 @@
+// Host benchmark for the label charset engine, conversions per second for the label shapes the receiver sees
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include "../../src/charset.h"
+
+#define BENCH_ROUNDS 2000000
+
+static volatile size_t sink;
+
+static void bench(const char* name, const char* input, size_t size, uint8_t charset, size_t outputSize) {
+  char output[400];
+  size_t length = charsetLength(input, charset, size);
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_ROUNDS; i++) sink += charsetConvert(input, length, charset, output, outputSize);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%-24s %7.1f ns/label %8.1f MB/s  \"%.40s\"\n", name, seconds * 1e9 / BENCH_ROUNDS, length * (double)BENCH_ROUNDS / seconds / 1e6, output);
+}
+
+int main(void) {
+  char dls[128];
+  memset(dls, 0, sizeof(dls));
+  for (size_t i = 0; i < sizeof(dls) - 1; i++) dls[i] = "Now playing: K\x99nstler - Lied \x9B\x80 "[i % 33];
+
+  char dlsUTF8[128];
+  memset(dlsUTF8, 0, sizeof(dlsUTF8));
+  for (size_t i = 0; i + 2 < sizeof(dlsUTF8) - 1; i += 3) memcpy(&dlsUTF8[i], (i % 2) ? "\xC3\xA9" "a" : "b\xC3\xB6", 3);
+
+  const char ucs2[16] = {0x04, 0x20, 0x04, 0x30, 0x04, 0x34, 0x04, 0x38, 0x04, 0x3E, 0x00, ' ', 0x00, '1', 0x00, 0x00};
+
+  bench("EBU Latin ASCII label", "Radio 1 Classic ", 17, CHARSET_EBU_LATIN, 49);
+  bench("EBU Latin label", "Z\x99rich \x80\x82\x83 \xA9", 17, CHARSET_EBU_LATIN, 49);
+  bench("UTF-8 label", "Caf\xC3\xA9 Z\xC3\xBCrich", 17, CHARSET_EBU_LATIN, 49);
+  bench("UCS-2 label", ucs2, sizeof(ucs2), CHARSET_UCS2, 49);
+  bench("EBU Latin radiotext", dls, sizeof(dls), CHARSET_EBU_LATIN, 385);
+  bench("UTF-8 radiotext", dlsUTF8, sizeof(dlsUTF8), CHARSET_UTF8, 385);
+  return 0;
+}
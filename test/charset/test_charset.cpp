@@ -0,0 +1,108 @@
+// Host test for the label charset engine: every EBU Latin code against ETSI TS 101 756 figure C.1,
+// UCS-2 and UTF-8 decoding and truncation into small buffers.
+
+#include <stdio.h>
+#include <string.h>
+#include "../../src/charset.h"
+
+// Figure C.1 row by row, "" where the code is not a character (0x00 and the word break 0x1F),
+// a space for the preferred line break and end of headline codes
+static const char* const EBULatinSpec[256] = {
+  "",  "Ę", "Į", "Ų", "Ă", "Ė", "Ď", "Ș", "Ț", "Ċ", " ", " ", "Ġ", "Ĺ", "Ż", "Ń",
+  "ą", "ę", "į", "ų", "ă", "ė", "ď", "ș", "ț", "ċ", "Ň", "Ě", "ġ", "ĺ", "ż", "",
+  " ", "!", "\"", "#", "ł", "%", "&", "'", "(", ")", "*", "+", ",", "-", ".", "/",
+  "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ":", ";", "<", "=", ">", "?",
+  "@", "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O",
+  "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z", "[", "Ů", "]", "Ł", "_",
+  "Ą", "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o",
+  "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z", "«", "ů", "»", "Ľ", "Ħ",
+  "á", "à", "é", "è", "í", "ì", "ó", "ò", "ú", "ù", "Ñ", "Ç", "Ş", "ß", "¡", "Ÿ",
+  "â", "ä", "ê", "ë", "î", "ï", "ô", "ö", "û", "ü", "ñ", "ç", "ş", "ğ", "ı", "ÿ",
+  "Ķ", "Ņ", "©", "Ģ", "Ğ", "ě", "ň", "ő", "Ő", "€", "£", "$", "Ā", "Ē", "Ī", "Ū",
+  "ķ", "ņ", "Ļ", "ģ", "ļ", "İ", "ń", "ű", "Ű", "¿", "ľ", "°", "ā", "ē", "ī", "ū",
+  "Á", "À", "É", "È", "Í", "Ì", "Ó", "Ò", "Ú", "Ù", "Ř", "Č", "Š", "Ž", "Ð", "Ŀ",
+  "Â", "Ä", "Ê", "Ë", "Î", "Ï", "Ô", "Ö", "Û", "Ü", "ř", "č", "š", "ž", "đ", "ŀ",
+  "Ã", "Å", "Æ", "Œ", "ŷ", "Ý", "Õ", "Ø", "Þ", "Ŋ", "Ŕ", "Ć", "Ś", "Ź", "Ť", "ð",
+  "ã", "å", "æ", "œ", "ŵ", "ý", "õ", "ø", "þ", "ŋ", "ŕ", "ć", "ś", "ź", "ť", "ħ",
+};
+
+static int failures;
+
+static void expect(const char* name, const char* got, const char* want) {
+  if (strcmp(got, want) == 0) return;
+  printf("FAIL %s: got \"%s\", want \"%s\"\n", name, got, want);
+  failures++;
+}
+
+static const char* convert(const char* input, size_t size, uint8_t charset, char* output, size_t outputSize) {
+  charsetConvert(input, charsetLength(input, charset, size), charset, output, outputSize);
+  return output;
+}
+
+static void testEBULatinTable(void) {
+  char name[32];
+  char output[8];
+  for (int code = 0; code < 256; code++) {
+    char input[2] = {(char)code, 0};
+    // A lone byte is never valid UTF-8, so this always goes through the table
+    charsetConvert(input, 1, CHARSET_EBU_LATIN, output, sizeof(output));
+    snprintf(name, sizeof(name), "EBU Latin 0x%02X", code);
+    expect(name, output, EBULatinSpec[code]);
+  }
+}
+
+static void testEBULatinLabels(void) {
+  char output[64];
+  expect("EBU label", convert("Radio Z\xB8rich", 17, CHARSET_EBU_LATIN, output, sizeof(output)), "Radio ZŰrich");
+  expect("EBU polish", convert("\x24\xF3" "d\x84", 17, CHARSET_EBU_LATIN, output, sizeof(output)), "łœdí");
+  expect("EBU terminated", convert("AB\0CD", 5, CHARSET_EBU_LATIN, output, sizeof(output)), "AB");
+  expect("EBU sent as UTF-8", convert("Caf\xC3\xA9", 17, CHARSET_EBU_LATIN, output, sizeof(output)), "Café");
+  expect("Latin-1", convert("Caf\xE9", 17, CHARSET_LATIN1, output, sizeof(output)), "Café");
+}
+
+static void testUCS2(void) {
+  char output[64];
+  const char label[16] = {0x00, 'A', 0x00, (char)0xE9, 0x20, (char)0xAC, 0x04, 0x1F, 0x00, 0x00, 'X', 'X'};
+  expect("UCS-2", convert(label, sizeof(label), CHARSET_UCS2, output, sizeof(output)), "Aé€П");
+
+  // A full 16 byte label has no terminator, the buffer size ends it
+  const char full[16] = {0x00, 'a', 0x00, 'b', 0x00, 'c', 0x00, 'd', 0x00, 'e', 0x00, 'f', 0x00, 'g', 0x00, 'h'};
+  expect("UCS-2 full", convert(full, sizeof(full), CHARSET_UCS2, output, sizeof(output)), "abcdefgh");
+
+  const char surrogate[4] = {(char)0xD8, 0x3D, 0x00, 'z'};
+  expect("UCS-2 surrogate", convert(surrogate, sizeof(surrogate), CHARSET_UCS2, output, sizeof(output)), "?z");
+}
+
+static void testUTF8(void) {
+  char output[64];
+  expect("UTF-8", convert("\xE2\x82\xAC 5", 17, CHARSET_UTF8, output, sizeof(output)), "€ 5");
+  expect("UTF-8 overlong", convert("\xC0\xAF!", 17, CHARSET_UTF8, output, sizeof(output)), "?" "?!");
+  expect("UTF-8 surrogate", convert("\xED\xA0\x80", 17, CHARSET_UTF8, output, sizeof(output)), "???");
+  expect("UTF-8 cut", convert("ab\xE2\x82", 17, CHARSET_UTF8, output, sizeof(output)), "ab??");
+}
+
+static void testTruncation(void) {
+  char output[4];
+  expect("truncate ASCII", convert("abcdef", 17, CHARSET_EBU_LATIN, output, sizeof(output)), "abc");
+  expect("truncate EBU", convert("a\x80\x80", 17, CHARSET_EBU_LATIN, output, sizeof(output)), "aá");
+  expect("truncate UTF-8", convert("\xC3\xA9\xC3\xA9", 17, CHARSET_UTF8, output, sizeof(output)), "é");
+
+  char one[1] = {'x'};
+  charsetConvert("abc", 3, CHARSET_EBU_LATIN, one, sizeof(one));
+  expect("truncate empty", one, "");
+}
+
+int main(void) {
+  testEBULatinTable();
+  testEBULatinLabels();
+  testUCS2();
+  testUTF8();
+  testTruncation();
+
+  if (failures > 0) {
+    printf("%d charset checks failed\n", failures);
+    return 1;
+  }
+  printf("charset: all checks passed\n");
+  return 0;
+}
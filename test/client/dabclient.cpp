@@ -0,0 +1,210 @@
+#include "dabclient.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using std::chrono::steady_clock;
+
+static steady_clock::time_point deadlineIn(int timeout) {
+  return steady_clock::now() + std::chrono::milliseconds(timeout);
+}
+
+DABClient::DABClient(int fd) : fd(fd), pingToken(0) {
+  resetStats();
+}
+
+bool DABClient::send(const std::string& command) {
+  std::string line = command + "\n";
+  size_t done = 0;
+  while (done < line.size()) {
+    ssize_t written = write(fd, line.data() + done, line.size() - done);
+    if (written < 0) {
+      if (errno == EINTR || errno == EAGAIN) continue;
+      return false;
+    }
+    done += written;
+  }
+  return true;
+}
+
+bool DABClient::receive(DABMessage& message, int timeout) {
+  std::string line;
+  if (!readLine(line, deadlineIn(timeout))) return false;
+  parse(line, message);
+  return true;
+}
+
+bool DABClient::expect(const std::string& prefix, DABMessage& message, int timeout) {
+  steady_clock::time_point deadline = deadlineIn(timeout);
+  std::string line;
+  while (readLine(line, deadline)) {
+    if (line.compare(0, prefix.size(), prefix) != 0) continue;
+    parse(line, message);
+    return true;
+  }
+  return false;
+}
+
+bool DABClient::command(const std::string& command, int timeout) {
+  if (!send(command)) return false;
+  DABMessage message;
+  if (!expect("#", message, timeout)) return false;
+  return message.value == "0";
+}
+
+double DABClient::ping(int timeout) {
+  std::string token = std::to_string(++pingToken);
+  std::string answer = "*PING=" + token + ",";
+  steady_clock::time_point start = steady_clock::now();
+  steady_clock::time_point deadline = deadlineIn(timeout);
+  counters.pings++;
+  if (!send("PING=" + token)) return -1;
+
+  std::string line;
+  while (readLine(line, deadline)) {
+    if (line.compare(0, answer.size(), answer) != 0) continue;
+    double rtt = std::chrono::duration<double, std::milli>(steady_clock::now() - start).count();
+    if (rtt < counters.rttMin) counters.rttMin = rtt;
+    if (rtt > counters.rttMax) counters.rttMax = rtt;
+    counters.rttSum += rtt;
+    return rtt;
+  }
+  counters.pingsLost++;
+  return -1;
+}
+
+void DABClient::drain(int duration) {
+  steady_clock::time_point deadline = deadlineIn(duration);
+  std::string line;
+  while (readLine(line, deadline));
+}
+
+void DABClient::resetStats(void) {
+  counters = DABStats();
+  counters.rttMin = 1e9;
+  started = steady_clock::now();
+}
+
+DABStats DABClient::stats(void) {
+  DABStats result = counters;
+  result.seconds = std::chrono::duration<double>(steady_clock::now() - started).count();
+  if (result.pings == result.pingsLost) result.rttMin = 0;
+  return result;
+}
+
+// Every line that comes in is counted here, whoever asked for it
+bool DABClient::readLine(std::string& line, steady_clock::time_point deadline) {
+  for (;;) {
+    size_t end = pending.find('\n');
+    if (end != std::string::npos || pending.size() >= DABCLIENT_LINE_MAX) {
+      bool overlong = (end == std::string::npos);
+      if (overlong) end = DABCLIENT_LINE_MAX;
+      line.assign(pending, 0, end);
+      pending.erase(0, overlong ? end : end + 1);
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+
+      DABMessage message;
+      parse(line, message);
+      DABCounter& counter = counters.byMessage[std::string(1, message.kind) + message.name];
+      counter.messages++;
+      counter.bytes += line.size() + 1;
+      counters.messages++;
+      counters.bytes += line.size() + 1;
+      if (overlong) counters.overlong++;
+      return true;
+    }
+
+    int timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - steady_clock::now()).count();
+    if (timeout < 0) return false;
+    struct pollfd ready = {fd, POLLIN, 0};
+    if (poll(&ready, 1, timeout) <= 0) {
+      if (steady_clock::now() >= deadline) return false;
+      continue;
+    }
+    char buffer[4096];
+    ssize_t length = read(fd, buffer, sizeof(buffer));
+    if (length <= 0) return false;
+    pending.append(buffer, length);
+  }
+}
+
+void DABClient::parse(const std::string& line, DABMessage& message) {
+  message.kind = line.empty() ? 0 : line[0];
+  message.name.clear();
+  message.value.clear();
+  if (message.kind == '$') {
+    if (line.size() > 1) message.name.assign(line, 1, 1);
+    if (line.size() > 3) message.value.assign(line, 3, std::string::npos);
+  } else if (message.kind == '#') {
+    message.value.assign(line, 1, std::string::npos);
+  } else if (!line.empty()) {
+    size_t equals = line.find('=');
+    message.name.assign(line, 1, equals == std::string::npos ? std::string::npos : equals - 1);
+    if (equals != std::string::npos) message.value.assign(line, equals + 1, std::string::npos);
+  }
+}
+
+std::string DABClient::param(const std::string& value, const char* key) {
+  std::string wanted = std::string(key) + "=";
+  for (size_t at = 0; at < value.size();) {
+    if (value.compare(at, wanted.size(), wanted) == 0) {
+      size_t start = at + wanted.size();
+      size_t end = value.find_first_of(",;", start);
+      return value.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    }
+    at = value.find_first_of(",;", at);
+    if (at == std::string::npos) break;
+    at++;
+  }
+  return "";
+}
+
+bool DABClient::chunk(const DABMessage& message, DABChunk& chunk) {
+  if (message.kind != '$' || message.name != "M" || message.value.compare(0, 6, "CHUNK=") != 0) return false;
+
+  size_t first = message.value.find(',', 6);
+  size_t second = (first == std::string::npos) ? first : message.value.find(',', first + 1);
+  size_t third = (second == std::string::npos) ? second : message.value.find(',', second + 1);
+  if (third == std::string::npos) return false;
+
+  chunk.id = strtoul(message.value.substr(6, first - 6).c_str(), nullptr, 16);
+  chunk.offset = strtoul(message.value.substr(first + 1, second - first - 1).c_str(), nullptr, 10);
+  uint32_t crc = strtoul(message.value.substr(second + 1, third - second - 1).c_str(), nullptr, 16);
+  chunk.valid = base64(message.value.substr(third + 1), chunk.data) && crc32(chunk.data.data(), chunk.data.size(), 0) == crc;
+  return true;
+}
+
+bool DABClient::base64(const std::string& text, std::vector<uint8_t>& data) {
+  data.clear();
+  uint32_t bits = 0;
+  int count = 0;
+  for (char c : text) {
+    int value;
+    if (c >= 'A' && c <= 'Z') value = c - 'A';
+    else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+    else if (c >= '0' && c <= '9') value = c - '0' + 52;
+    else if (c == '+') value = 62;
+    else if (c == '/') value = 63;
+    else if (c == '=') break;
+    else return false;
+
+    bits = (bits << 6) | value;
+    count += 6;
+    if (count >= 8) {
+      count -= 8;
+      data.push_back((bits >> count) & 0xFF);
+    }
+  }
+  return true;
+}
+
+// The same CRC-32 the receiver puts on slides and chunks
+uint32_t DABClient::crc32(const uint8_t* data, size_t length, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
@@ -0,0 +1,79 @@
+// Host side of the receiver's serial protocol: frames the line stream, sorts it by message, keeps throughput
+// counters and times PING round trips. Works on any file descriptor, the pty of the host build or a real port.
+
+#ifndef dabclient_h
+#define dabclient_h
+
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#define DABCLIENT_LINE_MAX 8192  // Longer lines are cut and counted as overlong
+
+// One line. "$S=SIGNAL=1.0,LOCK=1" is kind '$', name "S", value "SIGNAL=1.0,LOCK=1"; "*PING=7,123" is kind
+// '*', name "PING", value "7,123"; "#0" is kind '#', name "", value "0".
+typedef struct _DABMessage {
+  char          kind;
+  std::string   name;
+  std::string   value;
+} DABMessage;
+
+// A slide or trace chunk: "$M=CHUNK=<id>,<offset>,<crc>,<base64>"
+typedef struct _DABChunk {
+  uint16_t              id;
+  size_t                offset;
+  std::vector<uint8_t>  data;
+  bool                  valid;  // Decoded and the CRC matches
+} DABChunk;
+
+typedef struct _DABCounter {
+  uint32_t  messages;
+  uint64_t  bytes;              // Including the newline
+} DABCounter;
+
+typedef struct _DABStats {
+  uint32_t  messages;
+  uint64_t  bytes;
+  uint32_t  overlong;
+  uint32_t  pings;
+  uint32_t  pingsLost;
+  double    rttMin;             // ms
+  double    rttMax;
+  double    rttSum;
+  double    seconds;            // Since the last resetStats()
+  std::map<std::string, DABCounter> byMessage;  // Keyed "$S", "*PING", "#"...
+} DABStats;
+
+class DABClient {
+  public:
+    explicit DABClient(int fd);
+
+    bool send(const std::string& command);                    // "TUNE=26", the newline is added
+    bool receive(DABMessage& message, int timeout);           // Next line within timeout ms
+    bool expect(const std::string& prefix, DABMessage& message, int timeout);  // Skips lines until one starts with prefix
+    bool command(const std::string& command, int timeout);    // Sends and waits for #0, false on #1 or nothing
+    double ping(int timeout);                                 // Round trip in ms, negative when the answer never came
+    void drain(int duration);                                 // Reads and counts for duration ms
+
+    void resetStats(void);
+    DABStats stats(void);
+
+    static std::string param(const std::string& value, const char* key);  // "LOCK" out of "SIGNAL=1.0,LOCK=1"
+    static bool chunk(const DABMessage& message, DABChunk& chunk);
+    static bool base64(const std::string& text, std::vector<uint8_t>& data);
+    static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc);
+
+  private:
+    bool readLine(std::string& line, std::chrono::steady_clock::time_point deadline);
+    void parse(const std::string& line, DABMessage& message);
+
+    int fd;
+    std::string pending;
+    uint32_t pingToken;
+    DABStats counters;
+    std::chrono::steady_clock::time_point started;
+};
+
+#endif
@@ -0,0 +1,89 @@
+// Host benchmark for the serial protocol: messages and bytes per second the device sends in each reporting mode,
+// with PING round trips timed while that traffic is flowing, and the slide transfer rate per window size.
+// Numbers are for the pty and the host CPU, compare them between protocol changes, not with the UART.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "device.h"
+#include "../client/dabclient.h"
+
+#define FS_DIR        "build/fs_bench_comms"
+#define BENCH_TIME    2000   // ms per mode
+#define PING_SPACING  20     // ms of traffic between two pings
+#define SLIDE_SIZE    65536
+
+static void report(const char* name, DABStats stats) {
+  uint32_t answered = stats.pings - stats.pingsLost;
+  printf("%-24s %8.0f msg/s %8.1f kB/s  rtt %6.2f/%6.2f/%6.2f ms  lost %u\n", name,
+         stats.messages / stats.seconds, stats.bytes / stats.seconds / 1000,
+         stats.rttMin, answered > 0 ? stats.rttSum / answered : 0, stats.rttMax, stats.pingsLost);
+}
+
+static void benchMode(DABClient& client, const char* name) {
+  client.resetStats();
+  for (int elapsed = 0; elapsed < BENCH_TIME; elapsed += PING_SPACING) {
+    client.ping(1000);
+    client.drain(PING_SPACING);
+  }
+  report(name, client.stats());
+}
+
+static void benchSlide(DABClient& client, int window) {
+  client.command("WINDOW=" + std::to_string(window), 2000);
+  client.drain(50);
+  client.resetStats();
+  client.send("GETSLIDE=abcd");
+
+  DABMessage message;
+  DABChunk chunk;
+  size_t acked = 0;
+  while (acked < SLIDE_SIZE && client.expect("$M=CHUNK=", message, 2000) && DABClient::chunk(message, chunk)) {
+    if (chunk.valid && chunk.offset == acked) acked += chunk.data.size();
+    client.send("ACK=abcd," + std::to_string(acked));
+  }
+
+  DABStats stats = client.stats();
+  char name[32];
+  snprintf(name, sizeof(name), "slide window %d", window);
+  printf("%-24s %8.1f kB/s of image%s\n", name, acked / stats.seconds / 1000, acked < SLIDE_SIZE ? "  (incomplete)" : "");
+}
+
+int main(void) {
+  int fd = deviceStart(FS_DIR);
+  if (fd < 0) {
+    printf("no pty available\n");
+    return 1;
+  }
+  DABClient client(fd);
+
+  std::vector<uint8_t> image(SLIDE_SIZE);
+  for (size_t i = 0; i < image.size(); i++) image[i] = (uint8_t)(i * 7);
+  memcpy(image.data(), "\x89PNG\r\n\x1A\n", 8);
+  FILE* file = fopen(FS_DIR "/abcd.img", "wb");
+  fwrite(image.data(), 1, image.size(), file);
+  fclose(file);
+
+  DABMessage message;
+  client.send("ENABLE=1");
+  client.expect("*ENABLE=", message, 2000);
+  client.command("SERVICE=0", 2000);
+  client.drain(500);
+
+  benchMode(client, "idle, INTERVAL=100");
+  client.command("INTERVAL=10", 2000);
+  benchMode(client, "signal, INTERVAL=10");
+  client.command("INTERVAL=100", 2000);
+  client.command("TELEMETRY=1,1", 2000);
+  benchMode(client, "telemetry 1 ms, batch 1");
+  client.command("TELEMETRY=1,32", 2000);
+  benchMode(client, "telemetry 1 ms, batch 32");
+  client.command("TELEMETRY=0", 2000);
+
+  benchSlide(client, 1);
+  benchSlide(client, 8);
+  benchSlide(client, 32);
+
+  fflush(stdout);
+  _exit(0);
+}
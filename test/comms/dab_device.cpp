@@ -0,0 +1,15 @@
+// The receiver's serial side on a pty for clients in other processes: connect to the printed path, send ENABLE=1
+
+#include <stdio.h>
+#include <unistd.h>
+#include "device.h"
+
+int main(void) {
+  if (deviceStart("build/fs_device") < 0) {
+    printf("no pty available\n");
+    return 1;
+  }
+  printf("%s\n", deviceName());
+  fflush(stdout);
+  for (;;) pause();
+}
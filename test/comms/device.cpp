@@ -0,0 +1,95 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <thread>
+#include "device.h"
+#include <TFT_eSPI.h>
+#include "radiotask.h"
+#include "../si468x/script.h"
+
+// What comms.h and the radio task expect from the sketch
+bool ChannelListView;
+bool menu;
+bool setupmode;
+bool ShowServiceInformation;
+bool SlideShowView;
+bool store;
+bool trysetservice;
+bool wifi;
+byte dabfreq = CHANNEL_11C;
+byte language;
+byte subnetclient;
+char _serviceName[17];
+int ActiveColor;
+int ActiveColorSmooth;
+int BackgroundColor3;
+int InsignificantColor;
+int InsignificantColorSmooth;
+int SignificantColor;
+int SignificantColorSmooth;
+int16_t SignalLevel;
+uint32_t _serviceID;
+unsigned long recoverytime;
+
+DAB radio;
+RadioSnapshot snapshot;
+TFT_eSPI tft;
+Si468xEmulator emulator;
+
+static char name[64];
+
+void Communication(void);
+
+void tftPrint(int8_t offset, const String & text, int16_t x, int16_t y, int color, int smoothcolor, uint8_t fontsize) {}
+void loadFonts(bool option) {}
+void ShowFreq(void) {}
+void BuildDisplay(void) {}
+
+void setAnnouncements(uint16_t mask) {
+  radioPost(RADIO_ANNOUNCE, mask);
+}
+
+// loop() of the sketch without the display and the buttons
+static void deviceLoop(void) {
+  for (;;) {
+    RadioMessage event;
+    while (radioEvent(event)) {
+      if (event.type == RADIO_SCAN_DONE || event.type == RADIO_FOLLOWED) dabfreq = event.value & 0xFF;
+    }
+    radioSnapshot(snapshot);
+    SignalLevel = snapshot.rssi;
+    Communication();
+    yield();
+  }
+}
+
+int deviceStart(const char* fsDir) {
+  int client = posix_openpt(O_RDWR | O_NOCTTY);
+  if (client < 0 || grantpt(client) != 0 || unlockpt(client) != 0) return -1;
+  snprintf(name, sizeof(name), "%s", ptsname(client));
+  int device = open(name, O_RDWR | O_NOCTTY);
+  if (device < 0) return -1;
+
+  // Bytes go through untouched, like the USB CDC port
+  struct termios mode;
+  tcgetattr(device, &mode);
+  cfmakeraw(&mode);
+  tcsetattr(device, TCSANOW, &mode);
+
+  hostFilesystem(fsDir);
+  std::string script = std::string(fsDir) + SI468X_EMU_FILE;
+  writeScript(script.c_str());
+  emulator.load(SI468X_EMU_FILE);
+  radio.setBus(&emulator);
+  radio.begin(SI4684_SS);
+  radio.setFreq(dabfreq);
+  hostSerial(device, device);
+  radioStart(dabfreq);
+
+  std::thread(deviceLoop).detach();
+  return client;
+}
+
+const char* deviceName(void) {
+  return name;
+}
@@ -0,0 +1,12 @@
+// comms.cpp and the radio task on the Si468x emulator, wired to a pseudo-terminal so a client sees the same
+// byte stream the USB serial port carries on the receiver
+
+#ifndef test_device_h
+#define test_device_h
+
+// Writes the two-ensemble script into fsDir, starts the radio task and the UI loop on their own threads and
+// returns the client end of the pty, -1 when no pty could be opened
+int deviceStart(const char* fsDir);
+const char* deviceName(void);  // Path of the device end, for clients in other processes
+
+#endif
@@ -0,0 +1,187 @@
+// Host test for the serial protocol: comms.cpp runs on the emulator behind a pty and the client library talks to
+// it the way the PC application does, from ENABLE through service selection, EPG, telemetry and a slide transfer.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "device.h"
+#include <TimeLib.h>
+#include "epg.h"
+#include "../client/dabclient.h"
+
+#define FS_DIR    "build/fs_comms"
+#define SLIDE_ID  "abcd"
+#define SLIDE_SIZE 3000
+
+static int failures;
+
+static void expect(const char* name, long got, long want) {
+  if (got == want) return;
+  printf("FAIL %s: got %ld, want %ld\n", name, got, want);
+  failures++;
+}
+
+static void expect(const char* name, const std::string& got, const char* want) {
+  if (got == want) return;
+  printf("FAIL %s: got \"%s\", want \"%s\"\n", name, got.c_str(), want);
+  failures++;
+}
+
+// The first lines can come before the radio task has the list, wait for the one that has what is asked for
+static bool waitFor(DABClient& client, const char* prefix, const char* text, DABMessage& message) {
+  for (int i = 0; i < 1000; i++) {
+    if (!client.expect(prefix, message, 5000)) return false;
+    if (message.value.find(text) != std::string::npos) return true;
+  }
+  return false;
+}
+
+static void testEnable(DABClient& client) {
+  DABMessage message;
+  client.send("ENABLE=1");
+  expect("enable", client.expect("*ENABLE=", message, 2000), true);
+  expect("chip", message.value.substr(message.value.rfind(',') + 1), "SI4684/6.0.5");
+  expect("list", waitFor(client, "$L=", "0,4,Alpha;1,5,Bravo", message), true);
+  expect("list count", DABClient::param(message.value, "COUNT"), "2");
+  expect("list ensemble", DABClient::param(message.value, "ENSEMBLE"), "E123");
+}
+
+static void testService(DABClient& client) {
+  DABMessage message;
+  expect("service", client.command("SERVICE=1", 2000), true);
+  expect("service info", waitFor(client, "$I=", "SID=E1C2", message), true);
+  expect("radiotext", waitFor(client, "$D=RT=", "Second text", message), true);
+  expect("signal", waitFor(client, "$S=", "LOCK=1", message), true);
+  expect("signal cnr", DABClient::param(message.value, "CNR"), "20");
+  expect("bad service", client.command("SERVICE=9", 2000), false);
+}
+
+static void testEPG(DABClient& client) {
+  // Two programmes for Bravo in the format the EPG decoder stores
+  EPGProgramme programmes[2] = {{(uint32_t)now() - 600, 1800, "Morning Show"}, {(uint32_t)now() + 1200, 900, "News"}};
+  FILE* file = fopen(FS_DIR "/epg_e1c2.db", "wb");
+  fwrite(programmes, sizeof(EPGProgramme), 2, file);
+  fclose(file);
+
+  DABMessage message;
+  client.send("EPG=E1C2");
+  expect("epg now", client.expect("*EPGNOW=", message, 2000), true);
+  expect("epg now text", message.value, ("e1c2," + std::to_string(programmes[0].Start) + ",1800,Morning Show").c_str());
+  expect("epg next", client.expect("*EPGNEXT=", message, 2000), true);
+  expect("epg next text", message.value, ("e1c2," + std::to_string(programmes[1].Start) + ",900,News").c_str());
+  expect("epg done", client.expect("#", message, 2000) && message.value == "0", true);
+
+  // 0 asks for the running service, Bravo since testService()
+  expect("epg running", client.command("EPG=0", 2000), true);
+  expect("epg unknown", client.command("EPG=1234", 2000), false);
+}
+
+static void testFollow(DABClient& client) {
+  expect("follow on", client.command("FOLLOW=1", 2000), true);
+  expect("follow off", client.command("FOLLOW=0", 2000), true);
+  expect("follow bad", client.command("FOLLOW=2", 2000), false);
+}
+
+static void testAnnounce(DABClient& client) {
+  DABMessage message;
+  client.send("ANNOUNCE=3");
+  expect("announce echo", client.expect("*ANNOUNCE=", message, 2000), true);
+  expect("announce mask", message.value, "3");
+  expect("announce done", client.expect("#", message, 2000) && message.value == "0", true);
+  expect("announce off", client.command("ANNOUNCE=0", 2000), true);
+}
+
+static void testPing(DABClient& client) {
+  double rtt = client.ping(2000);
+  expect("ping answered", rtt >= 0, true);
+  expect("ping counted", client.stats().byMessage["*PING"].messages, 1);
+}
+
+static void testTelemetry(DABClient& client) {
+  DABMessage message;
+  expect("telemetry", client.command("TELEMETRY=5,4", 2000), true);
+  expect("telemetry frame", client.expect("$T=", message, 2000), true);
+  expect("telemetry batch", message.value.substr(message.value.find(',') + 1, 1), "4");
+  expect("telemetry off", client.command("TELEMETRY=0", 2000), true);
+}
+
+static void testSlide(DABClient& client) {
+  // A cached slide, PNG signature and then a counting pattern
+  std::vector<uint8_t> image(SLIDE_SIZE);
+  const uint8_t png[8] = {0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A};
+  for (size_t i = 0; i < image.size(); i++) image[i] = (i < sizeof(png)) ? png[i] : (uint8_t)(i * 7);
+  FILE* file = fopen(FS_DIR "/" SLIDE_ID ".img", "wb");
+  fwrite(image.data(), 1, image.size(), file);
+  fclose(file);
+
+  DABMessage message;
+  client.send("GETSLIDE=" SLIDE_ID);
+  expect("slide header", client.expect("$M=SLIDESHOW=", message, 2000), true);
+  expect("slide size", DABClient::param(message.value, "SIZE"), "3000");
+  expect("slide crc", strtoul(DABClient::param(message.value, "CRC").c_str(), nullptr, 16), DABClient::crc32(image.data(), image.size(), 0));
+
+  // Take the first chunk, then ask for it again: the transfer rewinds on the open file
+  DABChunk chunk;
+  expect("first chunk", client.expect("$M=CHUNK=", message, 2000) && DABClient::chunk(message, chunk), true);
+  expect("first offset", chunk.offset, 0);
+  client.send("ACK=" SLIDE_ID ",0");
+
+  std::vector<uint8_t> received(image.size());
+  size_t acked = 0;
+  uint32_t bad = 0;
+  while (acked < image.size() && client.expect("$M=CHUNK=", message, 2000) && DABClient::chunk(message, chunk)) {
+    if (!chunk.valid || chunk.offset + chunk.data.size() > received.size()) {
+      bad++;
+      continue;
+    }
+    memcpy(&received[chunk.offset], chunk.data.data(), chunk.data.size());
+    if (chunk.offset == acked) acked += chunk.data.size();
+    client.send("ACK=" SLIDE_ID "," + std::to_string(acked));
+  }
+  expect("slide complete", acked, SLIDE_SIZE);
+  expect("slide chunks valid", bad, 0);
+  expect("slide data", memcmp(received.data(), image.data(), image.size()), 0);
+}
+
+static void testTune(DABClient& client) {
+  DABMessage message;
+  expect("tune", client.command("TUNE=29", 2000), true);
+  expect("tuned list", waitFor(client, "$L=", "0,4,Charlie", message), true);
+  expect("bad tune", client.command("TUNE=255", 2000), false);
+}
+
+static void testStats(DABClient& client) {
+  DABMessage message;
+  client.send("STATS=1");
+  expect("stats", client.expect("*STATS=", message, 2000), true);
+  expect("stats sent", strtoul(DABClient::param(message.value, "TX").c_str(), nullptr, 10) > 0, true);
+}
+
+int main(void) {
+  int fd = deviceStart(FS_DIR);
+  if (fd < 0) {
+    printf("comms: no pty available, skipped\n");
+    return 0;
+  }
+  DABClient client(fd);
+
+  testEnable(client);
+  testService(client);
+  testEPG(client);
+  testFollow(client);
+  testAnnounce(client);
+  testPing(client);
+  testTelemetry(client);
+  testSlide(client);
+  testTune(client);
+  testStats(client);
+
+  if (failures > 0) {
+    printf("%d comms checks failed\n", failures);
+  } else {
+    printf("comms: all checks passed\n");
+  }
+  // The radio task and the UI loop never return
+  fflush(stdout);
+  _exit(failures > 0 ? 1 : 0);
+}
@@ -0,0 +1,159 @@
+// Just enough of the Arduino-ESP32 core to build the radio driver, the radio task and the serial protocol on Linux
+
+#ifndef host_arduino_h
+#define host_arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <string>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define HEX 16
+#define DEC 10
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_byte_near(address) (*(const uint8_t*)(address))
+#define digitalPinToInterrupt(pin) (pin)
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+char* itoa(int value, char* buffer, int base);
+
+class String {
+  public:
+    String(void) {}
+    String(const char* text) { if (text) s = text; }
+    String(const std::string& text) : s(text) {}
+    String(char c) : s(1, c) {}
+    String(int value, unsigned char base = DEC) : s(number((long)value, base)) {}
+    String(unsigned int value, unsigned char base = DEC) : s(number((unsigned long)value, base)) {}
+    String(long value, unsigned char base = DEC) : s(number(value, base)) {}
+    String(unsigned long value, unsigned char base = DEC) : s(number(value, base)) {}
+    String(unsigned char value, unsigned char base = DEC) : s(number((unsigned long)value, base)) {}
+    String(float value, unsigned char decimals = 2) : s(fixed(value, decimals)) {}
+    String(double value, unsigned char decimals = 2) : s(fixed(value, decimals)) {}
+
+    const char* c_str(void) const { return s.c_str(); }
+    unsigned int length(void) const { return s.size(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+    char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return s[index]; }
+
+    String& operator+=(const String& other) { s += other.s; return *this; }
+    String& operator+=(const char* other) { if (other) s += other; return *this; }
+    String& operator+=(char other) { s += other; return *this; }
+    String& operator+=(int other) { s += number((long)other, DEC); return *this; }
+    String& operator+=(unsigned int other) { s += number((unsigned long)other, DEC); return *this; }
+    String& operator+=(long other) { s += number(other, DEC); return *this; }
+    String& operator+=(unsigned long other) { s += number(other, DEC); return *this; }
+    bool concat(const String& other) { s += other.s; return true; }
+    bool concat(const char* other) { if (other) s += other; return true; }
+    bool concat(const char* other, unsigned int length) { s.append(other, length); return true; }
+    bool concat(char other) { s += other; return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a ? a : "") + b.s); }
+    friend String operator+(const String& a, char b) { return String(a.s + b); }
+
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator!=(const String& other) const { return s != other.s; }
+    bool operator==(const char* other) const { return s == (other ? other : ""); }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return s < other.s; }
+    bool equals(const String& other) const { return s == other.s; }
+    bool equalsIgnoreCase(const String& other) const { return strcasecmp(s.c_str(), other.s.c_str()) == 0; }
+    int compareTo(const String& other) const { return s.compare(other.s); }
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const { return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0; }
+
+    int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return found(s.find(text.s, from)); }
+    int lastIndexOf(char c) const { return found(s.rfind(c)); }
+    String substring(unsigned int from) const { return from > s.size() ? String() : String(s.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const { return from > s.size() || to < from ? String() : String(s.substr(from, to - from)); }
+
+    long toInt(void) const { return atol(s.c_str()); }
+    float toFloat(void) const { return atof(s.c_str()); }
+    void trim(void);
+    void toUpperCase(void) { for (char& c : s) c = toupper((unsigned char)c); }
+    void toLowerCase(void) { for (char& c : s) c = tolower((unsigned char)c); }
+    void replace(const String& from, const String& to);
+    void remove(unsigned int index) { if (index < s.size()) s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < s.size()) s.erase(index, count); }
+
+  private:
+    std::string s;
+    static std::string number(long value, unsigned char base);
+    static std::string number(unsigned long value, unsigned char base);
+    static std::string fixed(double value, unsigned char decimals);
+    static int found(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+};
+
+// Serial goes to a pair of file descriptors, stdin and stdout unless hostSerial() points it elsewhere
+class HardwareSerial {
+  public:
+    void begin(unsigned long baud) {}
+    void setTimeout(unsigned long timeout) { readTimeout = timeout; }
+    void setRxBufferSize(size_t size) {}
+    void setTxBufferSize(size_t size) {}
+    int available(void);
+    int availableForWrite(void) { return 256; }
+    int read(void);
+    int peek(void);
+    String readStringUntil(char terminator);
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length);
+    size_t print(const String& text) { return write((const uint8_t*)text.c_str(), text.length()); }
+    size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t println(const String& text = String()) { return print(text) + print("\n"); }
+    int printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void flush(void) {}
+    operator bool(void) const { return true; }
+
+    int input = 0;
+    int output = 1;
+
+  private:
+    unsigned long readTimeout = 1000;
+    int peeked = -1;
+};
+
+extern HardwareSerial Serial;
+
+void hostSerial(int input, int output);
+
+#include "freertos_host.h"
+
+#endif
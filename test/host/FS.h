@@ -0,0 +1,68 @@
+// fs::FS and fs::File on top of a host directory, see hostFilesystem()
+
+#ifndef host_fs_h
+#define host_fs_h
+
+#include "Arduino.h"
+#include <memory>
+#include <time.h>
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FileImpl;
+
+class File {
+  public:
+    File(void) {}
+    explicit File(std::shared_ptr<FileImpl> impl) : impl(impl) {}
+    operator bool(void) const;
+    size_t size(void);
+    size_t position(void);
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    int available(void);
+    int read(void);
+    size_t read(uint8_t* buffer, size_t length);
+    size_t readBytes(char* buffer, size_t length) { return read((uint8_t*)buffer, length); }
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t length);
+    size_t print(const String& text) { return write((const uint8_t*)text.c_str(), text.length()); }
+    void flush(void);
+    void close(void);
+    const char* name(void) const;
+    const char* path(void) const;
+    bool isDirectory(void) const;
+    File openNextFile(void);
+    time_t getLastWrite(void);
+
+  private:
+    std::shared_ptr<FileImpl> impl;
+};
+
+class FS {
+  public:
+    bool begin(bool formatOnFail = false) { return true; }
+    void end(void) {}
+    bool format(void);
+    File open(const char* path, const char* mode = "r");
+    File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char* path);
+    size_t totalBytes(void);
+    size_t usedBytes(void);
+};
+
+}
+
+using fs::File;
+
+// Directory that stands in for the flash filesystem, created when missing
+void hostFilesystem(const char* directory);
+
+#endif
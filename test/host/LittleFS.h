@@ -0,0 +1,10 @@
+#ifndef host_littlefs_h
+#define host_littlefs_h
+
+#include "FS.h"
+
+#define HOST_FS_SIZE 0x100000  // Same as the spiffs partition in partitions.csv
+
+extern fs::FS LittleFS;
+
+#endif
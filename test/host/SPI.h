@@ -0,0 +1,25 @@
+#ifndef host_spi_h
+#define host_spi_h
+
+#include "Arduino.h"
+
+#define MSBFIRST 1
+#define SPI_MODE0 0
+
+struct SPISettings {
+  SPISettings(uint32_t clock, uint8_t order, uint8_t mode) {}
+};
+
+// Never reached on the host, the driver runs on Si468xEmulator instead
+class SPIClass {
+  public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    void beginTransaction(SPISettings settings) {}
+    void endTransaction(void) {}
+    void transfer(void* data, uint32_t length) { memset(data, 0, length); }
+    void writeBytes(const uint8_t* data, uint32_t length) {}
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef host_tft_espi_h
+#define host_tft_espi_h
+
+#include "Arduino.h"
+
+// comms.h only names the type, nothing is drawn on the host
+class TFT_eSPI {
+};
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef host_timelib_h
+#define host_timelib_h
+
+#include <time.h>
+
+time_t now(void);
+void setTime(time_t t);
+
+#endif
@@ -0,0 +1,30 @@
+// FreeRTOS calls of the radio task and the driver mapped onto std::thread and std::recursive_mutex
+
+#ifndef host_freertos_h
+#define host_freertos_h
+
+#include <stdint.h>
+
+typedef void* TaskHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdMS_TO_TICKS(ms) (ms)
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void*), const char* name, uint32_t stack, void* parameter, unsigned priority, TaskHandle_t* handle, int core);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex);
+
+#endif
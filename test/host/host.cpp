@@ -0,0 +1,416 @@
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "SPI.h"
+#include "TimeLib.h"
+#include "mbedtls/base64.h"
+#include <chrono>
+#include <errno.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+SPIClass SPI;
+fs::FS LittleFS;
+
+static const auto started = std::chrono::steady_clock::now();
+static std::string fsRoot = "host_fs";
+static time_t timeOffset;
+
+unsigned long millis(void) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+unsigned long micros(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield(void) {
+  std::this_thread::yield();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t value) {}
+int digitalRead(uint8_t pin) { return HIGH; }
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {}
+void detachInterrupt(uint8_t pin) {}
+
+char* itoa(int value, char* buffer, int base) {
+  if (base == 16) sprintf(buffer, "%x", value); else sprintf(buffer, "%d", value);
+  return buffer;
+}
+
+time_t now(void) {
+  return time(nullptr) + timeOffset;
+}
+
+void setTime(time_t t) {
+  timeOffset = t - time(nullptr);
+}
+
+// String
+
+std::string String::number(long value, unsigned char base) {
+  if (base != DEC) return number((unsigned long)value, base);
+  char buffer[24];
+  snprintf(buffer, sizeof(buffer), "%ld", value);
+  return buffer;
+}
+
+std::string String::number(unsigned long value, unsigned char base) {
+  if (base < 2 || base > 36) base = DEC;
+  std::string digits;
+  do {
+    digits.insert(digits.begin(), "0123456789abcdefghijklmnopqrstuvwxyz"[value % base]);
+    value /= base;
+  } while (value > 0);
+  return digits;
+}
+
+std::string String::fixed(double value, unsigned char decimals) {
+  char buffer[48];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+  return buffer;
+}
+
+void String::trim(void) {
+  size_t first = s.find_first_not_of(" \t\r\n\f\v");
+  if (first == std::string::npos) {
+    s.clear();
+    return;
+  }
+  s = s.substr(first, s.find_last_not_of(" \t\r\n\f\v") - first + 1);
+}
+
+void String::replace(const String& from, const String& to) {
+  if (from.s.empty()) return;
+  for (size_t position = 0; (position = s.find(from.s, position)) != std::string::npos; position += to.s.size()) s.replace(position, from.s.size(), to.s);
+}
+
+// Serial
+
+void hostSerial(int input, int output) {
+  Serial.input = input;
+  Serial.output = output;
+}
+
+int HardwareSerial::available(void) {
+  int pending = 0;
+  if (ioctl(input, FIONREAD, &pending) != 0) pending = 0;
+  return pending + (peeked >= 0 ? 1 : 0);
+}
+
+int HardwareSerial::read(void) {
+  if (peeked >= 0) {
+    int c = peeked;
+    peeked = -1;
+    return c;
+  }
+  uint8_t c;
+  return (::read(input, &c, 1) == 1) ? c : -1;
+}
+
+int HardwareSerial::peek(void) {
+  if (peeked < 0 && available() > 0) peeked = read();
+  return peeked;
+}
+
+String HardwareSerial::readStringUntil(char terminator) {
+  std::string line;
+  unsigned long start = millis();
+  while (millis() - start < readTimeout) {
+    if (peeked < 0) {
+      struct pollfd ready = {input, POLLIN, 0};
+      if (poll(&ready, 1, 10) <= 0) continue;
+    }
+    int c = read();
+    if (c < 0) break;
+    if (c == terminator) break;
+    line += (char)c;
+  }
+  return String(line);
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t length) {
+  size_t done = 0;
+  while (done < length) {
+    ssize_t written = ::write(output, data + done, length - done);
+    if (written < 0) {
+      if (errno == EAGAIN || errno == EINTR) {
+        delay(1);
+        continue;
+      }
+      break;
+    }
+    done += written;
+  }
+  return done;
+}
+
+int HardwareSerial::printf(const char* format, ...) {
+  char buffer[512];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length > 0) write((const uint8_t*)buffer, min((size_t)length, sizeof(buffer) - 1));
+  return length;
+}
+
+// Filesystem
+
+namespace fs {
+
+struct FileImpl {
+  FILE* file = nullptr;
+  bool directory = false;
+  std::string path;
+  std::string name;
+  std::vector<std::string> entries;
+  size_t next = 0;
+};
+
+static std::string hostPath(const char* path) {
+  return fsRoot + (path[0] == '/' ? "" : "/") + path;
+}
+
+File::operator bool(void) const {
+  return impl && (impl->file != nullptr || impl->directory);
+}
+
+size_t File::size(void) {
+  if (!impl || !impl->file) return 0;
+  long current = ftell(impl->file);
+  fseek(impl->file, 0, SEEK_END);
+  long end = ftell(impl->file);
+  fseek(impl->file, current, SEEK_SET);
+  return end;
+}
+
+size_t File::position(void) {
+  return (impl && impl->file) ? ftell(impl->file) : 0;
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+  if (!impl || !impl->file) return false;
+  return fseek(impl->file, position, mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END)) == 0;
+}
+
+int File::available(void) {
+  return (int)(size() - position());
+}
+
+int File::read(void) {
+  uint8_t c;
+  return (read(&c, 1) == 1) ? c : -1;
+}
+
+size_t File::read(uint8_t* buffer, size_t length) {
+  if (!impl || !impl->file) return 0;
+  return fread(buffer, 1, length, impl->file);
+}
+
+size_t File::write(const uint8_t* buffer, size_t length) {
+  if (!impl || !impl->file) return 0;
+  return fwrite(buffer, 1, length, impl->file);
+}
+
+void File::flush(void) {
+  if (impl && impl->file) fflush(impl->file);
+}
+
+void File::close(void) {
+  if (impl && impl->file) fclose(impl->file);
+  impl.reset();
+}
+
+const char* File::name(void) const {
+  return impl ? impl->name.c_str() : "";
+}
+
+const char* File::path(void) const {
+  return impl ? impl->path.c_str() : "";
+}
+
+bool File::isDirectory(void) const {
+  return impl && impl->directory;
+}
+
+File File::openNextFile(void) {
+  if (!impl || !impl->directory || impl->next >= impl->entries.size()) return File();
+  std::string path = (impl->path == "/" ? "" : impl->path) + "/" + impl->entries[impl->next++];
+  return LittleFS.open(path.c_str(), "r");
+}
+
+time_t File::getLastWrite(void) {
+  struct stat info;
+  return (impl && stat(hostPath(impl->path.c_str()).c_str(), &info) == 0) ? info.st_mtime : 0;
+}
+
+File FS::open(const char* path, const char* mode) {
+  auto impl = std::make_shared<FileImpl>();
+  impl->path = path;
+  const char* slash = strrchr(path, '/');
+  impl->name = slash ? slash + 1 : path;
+
+  std::string full = hostPath(path);
+  struct stat info;
+  if (stat(full.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+    DIR* dir = opendir(full.c_str());
+    if (!dir) return File();
+    while (struct dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] != '.') impl->entries.push_back(entry->d_name);
+    }
+    closedir(dir);
+    std::sort(impl->entries.begin(), impl->entries.end());
+    impl->directory = true;
+    return File(impl);
+  }
+
+  // Arduino modes have no 'b', the host needs it to keep bytes as they are
+  std::string hostMode = mode;
+  hostMode.erase(std::remove(hostMode.begin(), hostMode.end(), 'b'), hostMode.end());
+  hostMode += "b";
+  impl->file = fopen(full.c_str(), hostMode.c_str());
+  return impl->file ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) {
+  struct stat info;
+  return stat(hostPath(path).c_str(), &info) == 0;
+}
+
+bool FS::remove(const char* path) {
+  return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+  return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+  return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool FS::format(void) {
+  File root = open("/");
+  for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+    std::string path = file.path();
+    file.close();
+    remove(path.c_str());
+  }
+  return true;
+}
+
+size_t FS::totalBytes(void) {
+  return HOST_FS_SIZE;
+}
+
+size_t FS::usedBytes(void) {
+  size_t used = 0;
+  File root = open("/");
+  for (File file = root.openNextFile(); file; file = root.openNextFile()) used += file.size();
+  return used;
+}
+
+}
+
+void hostFilesystem(const char* directory) {
+  fsRoot = directory;
+  ::mkdir(directory, 0755);
+}
+
+// FreeRTOS
+
+static thread_local std::thread::id taskID = std::this_thread::get_id();
+
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void*), const char* name, uint32_t stack, void* parameter, unsigned priority, TaskHandle_t* handle, int core) {
+  std::thread thread(task, parameter);
+  if (handle != nullptr) *handle = (TaskHandle_t)(uintptr_t)std::hash<std::thread::id>()(thread.get_id());
+  thread.detach();
+  return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+  return (TaskHandle_t)(uintptr_t)std::hash<std::thread::id>()(taskID);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  delay(ticks);
+}
+
+// There is no INTB on the host, the driver polls, so a notification never arrives
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+  delay(ticks);
+  return 0;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+  return new std::recursive_mutex();
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks) {
+  ((std::recursive_mutex*)mutex)->lock();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) {
+  ((std::recursive_mutex*)mutex)->unlock();
+  return pdTRUE;
+}
+
+// Base64
+
+static const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen) {
+  size_t needed = ((slen + 2) / 3) * 4;
+  *olen = needed + 1;
+  if (dst == nullptr || dlen < needed + 1) return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+
+  size_t o = 0;
+  for (size_t i = 0; i < slen; i += 3) {
+    uint32_t group = src[i] << 16 | (i + 1 < slen ? src[i + 1] << 8 : 0) | (i + 2 < slen ? src[i + 2] : 0);
+    dst[o++] = base64Alphabet[(group >> 18) & 0x3F];
+    dst[o++] = base64Alphabet[(group >> 12) & 0x3F];
+    dst[o++] = (i + 1 < slen) ? base64Alphabet[(group >> 6) & 0x3F] : '=';
+    dst[o++] = (i + 2 < slen) ? base64Alphabet[group & 0x3F] : '=';
+  }
+  dst[o] = '\0';
+  *olen = o;
+  return 0;
+}
+
+int mbedtls_base64_decode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen) {
+  uint32_t group = 0;
+  int bits = 0;
+  size_t o = 0;
+  for (size_t i = 0; i < slen && src[i] != '='; i++) {
+    const char* position = strchr(base64Alphabet, src[i]);
+    if (position == nullptr || src[i] == '\0') return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    group = (group << 6) | (position - base64Alphabet);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      if (o >= dlen) return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+      dst[o++] = (group >> bits) & 0xFF;
+    }
+  }
+  *olen = o;
+  return 0;
+}
@@ -0,0 +1,250 @@
+// Host test for the radio task model: the SPSC rings never make either side wait, the radio task keeps
+// running when the UI stops draining events, a selection shows in the snapshot as soon as it is posted and
+// the radio task samples telemetry into its own ring and a bus trace is started and stopped by the radio
+// task alone.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include "radiotask.h"
+#include "../si468x/script.h"
+
+#define FS_DIR        "build/fs_radiotask"
+#define PUSH_LIMIT_US 1000  // A push that takes longer than this waited for the other side
+#define ITEMS         100000
+
+DAB radio;
+RadioSnapshot snapshot;
+unsigned long recoverytime;
+
+static int failures;
+
+static void expect(const char* name, long got, long want) {
+  if (got == want) return;
+  printf("FAIL %s: got %ld, want %ld\n", name, got, want);
+  failures++;
+}
+
+static void expect(const char* name, const char* got, const char* want) {
+  if (strcmp(got, want) == 0) return;
+  printf("FAIL %s: got \"%s\", want \"%s\"\n", name, got, want);
+  failures++;
+}
+
+static bool waitFor(bool (*done)(void), unsigned long timeout) {
+  unsigned long start = millis();
+  while (!done()) {
+    if (millis() - start > timeout) return false;
+    delay(1);
+  }
+  return true;
+}
+
+// Nobody pops: every push past the capacity fails at once instead of waiting for room
+static void testStalledConsumer(void) {
+  SPSCQueue<RadioMessage, RADIO_QUEUE_SIZE> queue;
+  uint32_t accepted = 0;
+  uint32_t refused = 0;
+  unsigned long slowest = 0;
+
+  for (uint32_t i = 0; i < 1000; i++) {
+    RadioMessage message = {RADIO_TUNE, i};
+    unsigned long start = micros();
+    if (queue.push(message)) accepted++; else refused++;
+    slowest = max(slowest, micros() - start);
+  }
+  expect("stalled accepted", accepted, RADIO_QUEUE_SIZE - 1);
+  expect("stalled refused", refused, 1000 - (RADIO_QUEUE_SIZE - 1));
+  expect("stalled push waits", slowest < PUSH_LIMIT_US, true);
+
+  RadioMessage message;
+  for (uint32_t i = 0; i < RADIO_QUEUE_SIZE - 1; i++) {
+    expect("stalled order", queue.pop(message) ? message.value : -1, i);
+  }
+  expect("stalled empty", queue.pop(message), false);
+}
+
+// Producer and consumer on their own threads, the consumer pausing now and then. Call times are only
+// checked above, a thread that is preempted mid call says nothing about the ring.
+static void testConcurrent(void) {
+  static SPSCQueue<RadioMessage, RADIO_QUEUE_SIZE> queue;
+  std::atomic<bool> producing(true);
+  uint32_t refused = 0;
+  uint32_t received = 0;
+  uint32_t outOfOrder = 0;
+
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < ITEMS;) {
+      RadioMessage message = {RADIO_TUNE, i};
+      if (queue.push(message)) {
+        i++;
+      } else {
+        refused++;
+        std::this_thread::yield();  // Give a single core to the consumer
+      }
+    }
+    producing = false;
+  });
+
+  RadioMessage message;
+  for (;;) {
+    bool more = producing;  // Read first, an empty ring after the producer finished means everything arrived
+    if (queue.pop(message)) {
+      if (message.value != received) outOfOrder++;
+      received++;
+      if (received % 10000 == 0) delay(1);  // Stall long enough for the ring to fill
+    } else if (!more) {
+      break;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  expect("concurrent received", received, ITEMS);
+  expect("concurrent order", outOfOrder, 0);
+  expect("concurrent refused some", refused > 0, true);
+}
+
+static uint32_t posted;
+
+static bool commandsDone(void) {
+  radioSnapshot(snapshot);
+  return snapshot.CommandsDone >= posted;
+}
+
+static bool listShown(void) {
+  radioSnapshot(snapshot);
+  return snapshot.numberofservices == 2;
+}
+
+// The UI never reads an event, the radio task has to get through every command anyway
+static void testFullEventQueue(void) {
+  for (uint32_t i = 0; i < 4 * RADIO_QUEUE_SIZE; i++) {
+    unsigned long start = millis();
+    while (!radioPost(RADIO_TUNE, (i & 1) ? CHANNEL_12B : CHANNEL_11C)) {
+      if (millis() - start > 5000) break;
+      delay(1);
+    }
+    posted++;
+  }
+  expect("full events, commands done", waitFor(commandsDone, 10000), true);
+
+  uint32_t drained = 0;
+  RadioMessage event;
+  while (radioEvent(event)) drained++;
+  expect("full events, ring full", drained, RADIO_QUEUE_SIZE - 1);
+}
+
+static void testSelection(void) {
+  radioPost(RADIO_TUNE, CHANNEL_11C);
+  posted++;
+  expect("tuned list", waitFor(listShown, 5000), true);
+  expect("tuned label", snapshot.service[1].Label, "Bravo");
+
+  // Seen by the UI right away, before the radio task has started the service
+  radioPost(RADIO_SERVICE, snapshot.service[1].ServiceID);
+  posted++;
+  radioSnapshot(snapshot);
+  expect("posted index", snapshot.ServiceIndex, 1);
+  expect("posted start", snapshot.ServiceStart, true);
+
+  expect("service done", waitFor(commandsDone, 5000), true);
+  expect("published index", snapshot.ServiceIndex, 1);
+  expect("published start", snapshot.ServiceStart, true);
+
+  // A service that dropped out of the list is ignored rather than starting whatever took its place
+  radioPost(RADIO_SERVICE, 0xE1FF);
+  posted++;
+  expect("missing done", waitFor(commandsDone, 5000), true);
+  expect("missing index", snapshot.ServiceIndex, 1);
+
+  radioPost(RADIO_CLEAR);
+  posted++;
+  radioSnapshot(snapshot);
+  expect("cleared index", snapshot.ServiceIndex, 0);
+  expect("cleared start", snapshot.ServiceStart, false);
+  expect("clear done", waitFor(commandsDone, 5000), true);
+  expect("published clear", snapshot.ServiceStart, false);
+}
+
+static void testTelemetry(void) {
+  TelemetrySample sample;
+  radioPost(RADIO_TELEMETRY, 1);
+  delay(500);  // Nobody drains, the ring fills and the rest is counted
+
+  uint32_t received = 0;
+  uint32_t late = 0;
+  uint32_t last = 0;
+  while (radioTelemetry(sample)) {
+    if (received > 0 && sample.time < last) late++;
+    last = sample.time;
+    received++;
+  }
+  expect("telemetry ring full", received, TELEMETRY_SAMPLES - 1);
+  expect("telemetry in order", late, 0);
+  expect("telemetry cnr", sample.cnr, 20);
+  expect("telemetry dropped", radioTelemetryDropped() > 0, true);
+
+  radioPost(RADIO_TELEMETRY, 0);
+  delay(100);
+  while (radioTelemetry(sample));
+  radioTelemetryDropped();
+  delay(100);
+  expect("telemetry stopped", radioTelemetry(sample), false);
+  expect("telemetry no drops", radioTelemetryDropped(), 0);
+}
+
+static bool tracing(void) {
+  radioSnapshot(snapshot);
+  return snapshot.Tracing;
+}
+
+static bool notTracing(void) {
+  return !tracing();
+}
+
+static void testTrace(void) {
+  expect("chip", snapshot.Chip, "SI4684/6.0.5");
+
+  radioPost(RADIO_TRACE, 1);
+  expect("trace started", waitFor(tracing, 5000), true);
+  radioPost(RADIO_TUNE, CHANNEL_12B);
+  radioPost(RADIO_TRACE, 0);
+  expect("trace stopped", waitFor(notTracing, 5000), true);
+
+  // Closed by the radio task, the UI streams it without touching the bus
+  File trace = LittleFS.open(SI468X_TRACE_FILE, "r");
+  expect("trace written", trace && trace.size() > 0, true);
+  trace.close();
+  expect("trace complete", snapshot.TraceTruncated, false);
+}
+
+int main(void) {
+  testStalledConsumer();
+  testConcurrent();
+
+  hostFilesystem(FS_DIR);
+  writeScript(FS_DIR "/si468x.emu");
+  Si468xEmulator emulator;
+  emulator.load("/si468x.emu");
+  radio.setBus(&emulator);
+  radio.begin(SI4684_SS);
+  radioStart(CHANNEL_11C);
+
+  testFullEventQueue();
+  testSelection();
+  testTelemetry();
+  testTrace();
+
+  if (failures > 0) {
+    printf("%d radiotask checks failed\n", failures);
+  } else {
+    printf("radiotask: all checks passed\n");
+  }
+  // The radio task never returns, leave without running destructors under it
+  fflush(stdout);
+  _exit(failures > 0 ? 1 : 0);
+}
@@ -0,0 +1,130 @@
+// Builds Si468x emulator scripts in the recorder's format and the two-ensemble script the host tests share
+
+#ifndef test_script_h
+#define test_script_h
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define CHANNEL_11C 26
+#define CHANNEL_12B 29
+#define CHANNEL_12C 30
+
+// Writes records the way Si468xRecorder does
+class Script {
+  public:
+    explicit Script(const char* path) { file = fopen(path, "wb"); }
+    ~Script() { fclose(file); }
+
+    void command(std::vector<uint8_t> bytes) { record('W', bytes); }
+
+    // A reply of the given read length, payload from data[5] on
+    void reply(uint16_t length, std::vector<uint8_t> payload, size_t at = 5) {
+      std::vector<uint8_t> bytes(length + 1, 0);
+      bytes[1] = 0x80;
+      for (size_t i = 0; i < payload.size() && at + i < bytes.size(); i++) bytes[at + i] = payload[i];
+      record('R', bytes);
+    }
+
+    void raw(const std::vector<uint8_t>& bytes) { record('R', bytes); }
+
+  private:
+    void record(char type, const std::vector<uint8_t>& bytes) {
+      uint8_t header[3] = {(uint8_t)type, (uint8_t)(bytes.size() & 0xFF), (uint8_t)(bytes.size() >> 8)};
+      fwrite(header, 1, sizeof(header), file);
+      fwrite(bytes.data(), 1, bytes.size(), file);
+    }
+    FILE* file;
+};
+
+static void label(std::vector<uint8_t>& bytes, size_t at, const char* text) {
+  for (size_t i = 0; i < 16; i++) bytes[at + i] = (i < strlen(text)) ? text[i] : ' ';
+}
+
+// A nonzero count claims more services than the list carries, the way a list cut short by a weak signal does
+static void serviceList(Script& script, std::vector<std::pair<uint32_t, const char*>> services, uint8_t count = 0) {
+  std::vector<uint8_t> list(13 + services.size() * 28, 0);
+  uint16_t length = list.size() - 6;
+  list[1] = 0x80;
+  list[5] = length & 0xFF;
+  list[6] = length >> 8;
+  list[7] = 1;  // Version
+  list[9] = count ? count : services.size();
+  size_t offset = 13;
+  for (auto& entry : services) {
+    for (int i = 0; i < 4; i++) list[offset + i] = (entry.first >> (8 * i)) & 0xFF;
+    list[offset + 5] = 1;  // One component
+    label(list, offset + 8, entry.second);
+    list[offset + 24] = entry.first & 0xFF;  // CompID, low byte of the SID
+    offset += 28;
+  }
+  script.command({0x80, 0x00});
+  script.raw(list);
+}
+
+static void componentType(Script& script, uint32_t serviceID, uint8_t type) {
+  std::vector<uint8_t> command = {0xBE, 0x00, 0x00, 0x00};
+  for (int i = 0; i < 4; i++) command.push_back((serviceID >> (8 * i)) & 0xFF);
+  command.push_back(serviceID & 0xFF);
+  command.insert(command.end(), {0x00, 0x00, 0x00});
+  script.command(command);
+  script.reply(12, {type});
+}
+
+static void dynamicLabel(Script& script, const char* text, bool toggle) {
+  uint16_t length = strlen(text) + 2;  // Both DLS prefix bytes count
+  std::vector<uint8_t> packet(length + 25, 0);
+  packet[1] = 0x80;
+  packet[8] = 0x80;  // DLS
+  packet[19] = length & 0xFF;
+  packet[20] = length >> 8;
+  packet[25] = toggle ? 0x80 : 0x00;
+  memcpy(&packet[27], text, strlen(text));
+  script.command({0x84, 0x01});
+  script.raw(packet);
+}
+
+static void ensemble(Script& script, uint8_t channel, uint16_t eid, const char* name) {
+  script.command({0xB0, 0x00, channel, 0x00, 0x00, 0x00});
+  std::vector<uint8_t> info(27, 0);
+  info[1] = 0x80;
+  info[5] = eid & 0xFF;
+  info[6] = eid >> 8;
+  label(info, 7, name);
+  info[23] = 0xE0;
+  script.command({0xB4, 0x00});
+  script.raw(info);
+}
+
+// 11C carries two audio services with radiotext, 12B one, 12C a list cut short after its first service. Signal and RSSI answer on every channel.
+static void writeScript(const char* path) {
+  Script script(path);
+  // Before any tune, so these answer on every channel. Scan status and signal status differ by argument.
+  script.command({0xB2, 0x09});
+  script.reply(19, {0x05, 0x00, 0x00, 100, 20}, 6);
+  script.command({0xB2, 0x01});
+  script.reply(24, {0x05, 0x00, 0x00, 90, 11}, 6);
+  script.command({0xE5, 0x00});
+  script.reply(6, {0x00, 0x28});
+
+  ensemble(script, CHANNEL_11C, 0xE123, "Test Mux");
+  serviceList(script, {{0xE1C1, "Alpha"}, {0xE1C2, "Bravo"}});
+  componentType(script, 0xE1C1, 4);
+  componentType(script, 0xE1C2, 5);
+  dynamicLabel(script, "Hello DAB", false);
+  dynamicLabel(script, "Second text", true);
+
+  ensemble(script, CHANNEL_12B, 0xE456, "Other Mux");
+  serviceList(script, {{0xE4D1, "Charlie"}});
+  componentType(script, 0xE4D1, 4);
+
+  ensemble(script, CHANNEL_12C, 0xE789, "Short Mux");
+  serviceList(script, {{0xE7E1, "Delta"}}, 2);
+  componentType(script, 0xE7E1, 4);
+}
+
+#endif
@@ -0,0 +1,178 @@
+// Host test for the Si468x emulator: the driver boots, tunes and reads an ensemble from a script,
+// replies depend on the command arguments and the tuned channel, and a recorded session replays.
+
+#include <stdio.h>
+#include <string.h>
+#include "si4684.h"
+#include "script.h"
+
+#define FS_DIR "build/fs_si468x"
+
+DAB radio;
+
+static int failures;
+
+static void expect(const char* name, const char* got, const char* want) {
+  if (strcmp(got, want) == 0) return;
+  printf("FAIL %s: got \"%s\", want \"%s\"\n", name, got, want);
+  failures++;
+}
+
+static void expect(const char* name, long got, long want) {
+  if (got == want) return;
+  printf("FAIL %s: got %ld, want %ld\n", name, got, want);
+  failures++;
+}
+
+static void settle(bool (*done)(void), bool scanning = false) {
+  unsigned long start = millis();
+  while (!done() && millis() - start < 3000) {
+    if (scanning) radio.ScanUpdate(); else radio.Update();
+    delay(2);
+  }
+}
+
+static bool listComplete(void) {
+  return radio.numberofservices > 0 && radio.EnsembleLabel[0] != '\0' && radio.getComponentsKnown();
+}
+
+static void testBoot(Si468xEmulator& emulator) {
+  radio.setBus(&emulator);
+  expect("begin", radio.begin(5, -1, false), true);
+  expect("chip", radio.getChipID(), "SI4684");
+  expect("firmware", radio.getFirmwareVersion(), "6.0.5");
+}
+
+static void testEnsemble(void) {
+  radio.setFreq(CHANNEL_11C);
+  expect("valid", radio.signalvalid, true);
+  settle(listComplete);
+  expect("ensemble", radio.EnsembleLabel, "Test Mux");
+  expect("EID", radio.EID, "E123");
+  expect("services", radio.numberofservices, 2);
+  expect("service 0", radio.service[0].Label, "Alpha");
+  expect("service 1", radio.service[1].Label, "Bravo");
+  expect("type 0", radio.service[0].ServiceType, 4);
+  expect("type 1", radio.service[1].ServiceType, 5);
+  expect("component generation", radio.ComponentGeneration, 2);  // One bump per type filled in
+  expect("cnr", radio.cnr, 20);
+
+  radio.getScanStatus();
+  expect("scan cnr", radio.cnr, 11);
+}
+
+static bool secondText(void) {
+  return strcmp(radio.ServiceData, "Second text") == 0;
+}
+
+static void testServiceData(void) {
+  radio.setService(0);
+  settle(secondText);
+  expect("radiotext", radio.ServiceData, "Second text");
+
+  // Used up, the chip hands out empty packets and the text stays
+  for (int i = 0; i < 20; i++) radio.Update();
+  expect("radiotext kept", radio.ServiceData, "Second text");
+}
+
+static bool servicesListed(void) {
+  return radio.numberofservices > 0;
+}
+
+static bool identityLive(void) {
+  return !radio.EnsembleCached && radio.EID[0] != '\0';
+}
+
+static void testChannels(void) {
+  radio.setFreq(CHANNEL_12B);
+  settle(listComplete);
+  expect("other ensemble", radio.EnsembleLabel, "Other Mux");
+  expect("other services", radio.numberofservices, 1);
+  expect("other service", radio.service[0].Label, "Charlie");
+
+  // An identity restored from the multiplex database gives way to the one on air
+  radio.setFreq(CHANNEL_12B);
+  strcpy(radio.EID, "E999");
+  strcpy(radio.EnsembleLabel, "Stale Mux");
+  radio.setCachedList(0);
+  settle(identityLive);
+  expect("live EID", radio.EID, "E456");
+  expect("live ensemble", radio.EnsembleLabel, "Other Mux");
+
+  // The scanner's reduced update is enough to get the whole list, types come in with it
+  radio.setFreq(CHANNEL_11C);
+  settle(servicesListed, true);
+  expect("back components", radio.getComponentsKnown(), true);
+  expect("back", radio.EnsembleLabel, "Test Mux");
+  expect("back services", radio.numberofservices, 2);
+  expect("back types", radio.service[1].ServiceType, 5);
+
+  // A list cut short keeps what came through but its version isn't taken, so the next poll reads it again
+  radio.setFreq(CHANNEL_12C);
+  settle(servicesListed);
+  expect("short services", radio.numberofservices, 1);
+  expect("short service", radio.service[0].Label, "Delta");
+  uint32_t skips = radio.ServiceListSkips;
+  for (int i = 0; i < 10; i++) {
+    radio.Update();
+    delay(100);
+  }
+  expect("short reread", radio.ServiceListSkips, skips);
+}
+
+static void testRecorder(Si468xEmulator& emulator) {
+  Si468xRecorder recorder;
+  expect("record", recorder.start(&emulator, "/session.trc"), true);
+  radio.setBus(&recorder);
+  radio.setFreq(CHANNEL_12B);
+  settle(listComplete);
+  recorder.stop();
+  expect("not truncated", recorder.truncated(), false);
+
+  // The recording alone is enough to bring the same ensemble back
+  Si468xEmulator replay;
+  expect("load recording", replay.load("/session.trc"), true);
+  radio.setBus(&replay);
+  radio.setFreq(CHANNEL_12B);
+  settle(listComplete);
+  expect("replayed ensemble", radio.EnsembleLabel, "Other Mux");
+  expect("replayed service", radio.service[0].Label, "Charlie");
+
+  // Long sessions stop growing at the cap instead of filling the flash
+  recorder.start(&emulator, "/long.trc");
+  uint8_t data[64];
+  for (int i = 0; i < 20000; i++) {
+    data[0] = 0xB2;
+    data[1] = 0x09;
+    recorder.transfer(data, 2);
+    memset(data, 0, sizeof(data));
+    recorder.transfer(data, 5);
+    recorder.transfer(data, 20);
+  }
+  recorder.stop();
+  File trace = LittleFS.open("/long.trc", "r");
+  expect("capped", trace.size() <= SI468X_TRACE_MAX && trace.size() > SI468X_TRACE_MAX - 64, true);
+  trace.close();
+  expect("truncated", recorder.truncated(), true);
+  radio.setBus(&emulator);
+}
+
+int main(void) {
+  hostFilesystem(FS_DIR);
+  writeScript(FS_DIR "/si468x.emu");
+
+  Si468xEmulator emulator;
+  expect("load", emulator.load("/si468x.emu"), true);
+  testBoot(emulator);
+  testEnsemble();
+  testServiceData();
+  testChannels();
+  testRecorder(emulator);
+
+  if (failures > 0) {
+    printf("%d si468x checks failed\n", failures);
+    return 1;
+  }
+  printf("si468x: all checks passed\n");
+  return 0;
+}